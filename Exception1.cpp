@@ -1,14 +1,65 @@
 #include<optional>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
 #include <set>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <stdexcept>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define SEARCH_SERVER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SEARCH_SERVER_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef SEARCH_SERVER_TRACING
+#include <cstdlib>
+#include <new>
+#endif
+
+#ifdef SEARCH_SERVER_TESTS
+#include <cstdlib>
+#endif
+
+#ifdef SEARCH_BENCHMARK
+#include <random>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+#endif
+
 using namespace std::string_literals;
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
@@ -28,30 +79,400 @@ int ReadLineWithNumber()
     return result;
 }
 
+//    , value != 0
+inline int CountTrailingZeros(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    int count = 0;
+    while ((value & 1) == 0)
+    {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+//  .        ['\0', ' ')
+struct Token
+{
+    std::string_view text;
+    bool is_valid;
+};
+
+#if defined(SEARCH_SERVER_AVX2)
+const size_t TOKENIZER_BLOCK_SIZE = 32;
+#else
+const size_t TOKENIZER_BLOCK_SIZE = 16;
+#endif
+
+//    :  i ,   i -    
+struct BlockMasks
+{
+    uint32_t spaces;
+    uint32_t controls;
+};
+
+inline BlockMasks ScanBlock(const char* block)
+{
+#if defined(SEARCH_SERVER_AVX2)
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i spaces = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+    //  bytes <= 0x1F:   0x1F    
+    const __m256i controls = _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, _mm256_set1_epi8(0x1F)), bytes);
+    return { static_cast<uint32_t>(_mm256_movemask_epi8(spaces)), static_cast<uint32_t>(_mm256_movemask_epi8(controls)) };
+#elif defined(SEARCH_SERVER_SSE2)
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    const __m128i spaces = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+    const __m128i controls = _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(0x1F)), bytes);
+    return { static_cast<uint32_t>(_mm_movemask_epi8(spaces)), static_cast<uint32_t>(_mm_movemask_epi8(controls)) };
+#else
+    BlockMasks masks{ 0, 0 };
+    for (size_t i = 0; i < TOKENIZER_BLOCK_SIZE; ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(block[i]);
+        masks.spaces |= static_cast<uint32_t>(c == ' ') << i;
+        masks.controls |= static_cast<uint32_t>(c < ' ') << i;
+    }
+    return masks;
+#endif
+}
+
+//             .
+//            ,  
+//        
+std::vector<Token> Tokenize(std::string_view text)
+{
+    const uint32_t block_bits = TOKENIZER_BLOCK_SIZE == 32 ? ~uint32_t{ 0 } : (uint32_t{ 1 } << TOKENIZER_BLOCK_SIZE) - 1;
+    std::vector<Token> tokens;
+    size_t word_start = 0;
+    bool is_valid = true;
+    //      
+    uint32_t carry = 0;
+    for (size_t base = 0; base < text.size(); base += TOKENIZER_BLOCK_SIZE)
+    {
+        const char* block = text.data() + base;
+        //   ,    
+        char tail[TOKENIZER_BLOCK_SIZE];
+        if (text.size() - base < TOKENIZER_BLOCK_SIZE)
+        {
+            std::fill(std::begin(tail), std::end(tail), ' ');
+            std::copy(block, text.data() + text.size(), tail);
+            block = tail;
+        }
+        const BlockMasks masks = ScanBlock(block);
+        const uint32_t words = ~masks.spaces & block_bits;
+        const uint32_t after_word = ((words << 1) | carry) & block_bits;
+        const uint32_t starts = words & ~after_word;
+        const uint32_t ends = masks.spaces & after_word;
+        carry = words >> (TOKENIZER_BLOCK_SIZE - 1);
+        for (uint32_t events = starts | ends | masks.controls; events != 0; events &= events - 1)
+        {
+            const uint32_t bit = events & (~events + 1);
+            const size_t position = base + CountTrailingZeros(events);
+            if (starts & bit)
+            {
+                word_start = position;
+                is_valid = true;
+            }
+            if (masks.controls & bit)
+            {
+                is_valid = false;
+            }
+            if (ends & bit)
+            {
+                tokens.push_back({ text.substr(word_start, position - word_start), is_valid });
+            }
+        }
+    }
+    if (carry)
+    {
+        tokens.push_back({ text.substr(word_start), is_valid });
+    }
+    return tokens;
+}
+
 std::vector<std::string> SplitIntoWords(const std::string& text) 
 {
     std::vector<std::string> words;
-    std::string word;
-    for (const char c : text) 
+    for (const Token& token : Tokenize(text))
+    {
+        words.emplace_back(token.text);
+    }
+    return words;
+}
+
+//   ASCII  CP1251:    ,    
+//   .   ,    Tokenize
+const std::array<char, 256>& GetSingleByteFoldTable()
+{
+    static const std::array<char, 256> table = []
     {
-        if (c == ' ')
+        std::array<char, 256> table{};
+        for (int c = 0; c < 256; ++c)
+        {
+            table[c] = static_cast<char>(c);
+        }
+        for (int c = '!'; c <= '~'; ++c)
         {
-            if (!word.empty()) 
+            const bool is_letter_or_digit = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+            if (!is_letter_or_digit)
             {
-                words.push_back(word);
-                word.clear();
+                table[c] = ' ';
             }
         }
-        else 
+        for (int c = 'A'; c <= 'Z'; ++c)
+        {
+            table[c] = static_cast<char>(c + ('a' - 'A'));
+        }
+        // -
+        for (int c = 0xC0; c <= 0xDF; ++c)
+        {
+            table[c] = static_cast<char>(c + 0x20);
+        }
+        // , , , , , , , , , , , , , , 
+        const std::pair<int, int> letter_pairs[] = { { 0xA8, 0xB8 }, { 0x80, 0x90 }, { 0x81, 0x83 }, { 0xAA, 0xBA },
+            { 0xBD, 0xBE }, { 0xB2, 0xB3 }, { 0xAF, 0xBF }, { 0xA3, 0xBC }, { 0x8A, 0x9A }, { 0x8C, 0x9C },
+            { 0x8E, 0x9E }, { 0x8D, 0x9D }, { 0xA1, 0xA2 }, { 0x8F, 0x9F }, { 0xA5, 0xB4 } };
+        for (const auto& [upper, lower] : letter_pairs)
+        {
+            table[upper] = static_cast<char>(lower);
+        }
+        // , , ,  , ,     
+        const int separators[] = { 0x82, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8B, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96,
+            0x97, 0x99, 0x9B, 0xA0, 0xA4, 0xA6, 0xA7, 0xA9, 0xAB, 0xAC, 0xAD, 0xAE, 0xB0, 0xB1, 0xB6, 0xB7, 0xB9, 0xBB };
+        for (const int c : separators)
         {
-            word += c;
+            table[c] = ' ';
         }
+        return table;
+    }();
+    return table;
+}
+
+//   UTF-8   , 0  ,      
+inline size_t GetUtf8SequenceLength(unsigned char lead)
+{
+    if (lead < 0x80)
+    {
+        return 1;
     }
-    if (!word.empty()) 
+    if (lead >= 0xC2 && lead <= 0xDF)
     {
-        words.push_back(word);
+        return 2;
     }
-    return words;
+    if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        return 3;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        return 4;
+    }
+    return 0;
+}
+
+inline uint32_t DecodeUtf8(const char* bytes, size_t length)
+{
+    static const uint32_t lead_masks[] = { 0, 0x7F, 0x1F, 0x0F, 0x07 };
+    uint32_t code_point = static_cast<unsigned char>(bytes[0]) & lead_masks[length];
+    for (size_t i = 1; i < length; ++i)
+    {
+        code_point = (code_point << 6) | (static_cast<unsigned char>(bytes[i]) & 0x3F);
+    }
+    return code_point;
+}
+
+//    UTF-8   text, 0    .  
+// ,      U+10FFFF 
+inline size_t GetValidUtf8SequenceLength(std::string_view text)
+{
+    const unsigned char lead = static_cast<unsigned char>(text[0]);
+    const size_t length = GetUtf8SequenceLength(lead);
+    if (length == 0 || length > text.size())
+    {
+        return 0;
+    }
+    for (size_t i = 1; i < length; ++i)
+    {
+        if ((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80)
+        {
+            return 0;
+        }
+    }
+    const unsigned char second = length > 1 ? static_cast<unsigned char>(text[1]) : 0;
+    if ((lead == 0xE0 && second < 0xA0) || (lead == 0xED && second > 0x9F) || (lead == 0xF0 && second < 0x90)
+        || (lead == 0xF4 && second > 0x8F))
+    {
+        return 0;
+    }
+    return length;
+}
+
+//     :     UTF-8,
+//   (  CP1251)  ,    U+10FFFF,      
+inline std::u32string DecodeSymbols(std::string_view word)
+{
+    std::u32string symbols;
+    symbols.reserve(word.size());
+    for (size_t i = 0; i < word.size();)
+    {
+        const size_t length = GetValidUtf8SequenceLength(word.substr(i));
+        if (length == 0)
+        {
+            symbols.push_back(static_cast<char32_t>(0x110000 + static_cast<unsigned char>(word[i])));
+            ++i;
+            continue;
+        }
+        symbols.push_back(static_cast<char32_t>(DecodeUtf8(word.data() + i, length)));
+        i += length;
+    }
+    return symbols;
+}
+
+//       , ' '      ,
+//    .       UTF-8,     
+uint32_t FoldCodePoint(uint32_t code_point)
+{
+    //  Latin-1     (U+00AA, U+00B2, U+00B3, U+00B5, U+00B9, U+00BA, U+00BC-U+00BE),
+    //    ,    Unicode, 
+    if ((code_point >= 0xA0 && code_point <= 0xBF && code_point != 0xAA && code_point != 0xB2 && code_point != 0xB3
+            && code_point != 0xB5 && code_point != 0xB9 && code_point != 0xBA && (code_point < 0xBC || code_point > 0xBE))
+        || code_point == 0xD7 || code_point == 0xF7 || code_point == 0x1680 || (code_point >= 0x2000 && code_point <= 0x206F)
+        || code_point == 0x2116 || (code_point >= 0x3000 && code_point <= 0x3003) || code_point == 0xFEFF)
+    {
+        return ' ';
+    }
+    //     U+00C0-U+00DE
+    if (code_point >= 0xC0 && code_point <= 0xDE)
+    {
+        return code_point + 0x20;
+    }
+    // Latin Extended-A:    ,     
+    if ((code_point >= 0x100 && code_point <= 0x12F) || (code_point >= 0x132 && code_point <= 0x137)
+        || (code_point >= 0x14A && code_point <= 0x177))
+    {
+        return code_point | 1;
+    }
+    if ((code_point >= 0x139 && code_point <= 0x148) || (code_point >= 0x179 && code_point <= 0x17E))
+    {
+        return code_point + (code_point & 1);
+    }
+    if (code_point == 0x178)
+    {
+        return 0xFF;
+    }
+    // U+0400-U+040F  -
+    if (code_point >= 0x400 && code_point <= 0x40F)
+    {
+        return code_point + 0x50;
+    }
+    if (code_point >= 0x410 && code_point <= 0x42F)
+    {
+        return code_point + 0x20;
+    }
+    //     ,  
+    if ((code_point >= 0x460 && code_point <= 0x481) || (code_point >= 0x48A && code_point <= 0x4BF)
+        || (code_point >= 0x4D0 && code_point <= 0x52F))
+    {
+        return code_point | 1;
+    }
+    if (code_point >= 0x4C1 && code_point <= 0x4CE)
+    {
+        return code_point + (code_point & 1);
+    }
+    if (code_point == 0x4C0)
+    {
+        return 0x4CF;
+    }
+    return code_point;
+}
+
+//   : ,   -
+enum class TextEncoding
+{
+    UTF8,
+    CP1251,
+};
+
+//    i   -  (  ).   
+//  UTF-8   ,    
+inline bool IsFoldedToSpace(std::string_view text, size_t i, TextEncoding encoding)
+{
+    if (i == text.size())
+    {
+        return true;
+    }
+    const unsigned char byte = static_cast<unsigned char>(text[i]);
+    if (byte < 0x80 || encoding == TextEncoding::CP1251)
+    {
+        return GetSingleByteFoldTable()[byte] == ' ';
+    }
+    const size_t length = GetValidUtf8SequenceLength(text.substr(i));
+    return length != 0 && FoldCodePoint(DecodeUtf8(text.data() + i, length)) == ' ';
+}
+
+//     :     ,    
+//   .    .  UTF-8   
+//  ,       .      ("-")
+//   .         ,     .
+//     :       
+std::string NormalizeText(std::string_view text, TextEncoding encoding, bool keep_query_syntax = false)
+{
+    const std::array<char, 256>& table = GetSingleByteFoldTable();
+    std::string normalized(text.size(), ' ');
+    for (size_t i = 0; i < text.size();)
+    {
+        const unsigned char byte = static_cast<unsigned char>(text[i]);
+        if (byte < 0x80 || encoding == TextEncoding::CP1251)
+        {
+            const char c = text[i];
+            normalized[i] = table[byte];
+            if (c == '-' || c == '\'' || c == '"' || c == '*')
+            {
+                const bool after_space = i == 0 || normalized[i - 1] == ' ';
+                const bool before_space = IsFoldedToSpace(text, i + 1, encoding);
+                const bool is_joiner = (c == '-' || c == '\'') && !after_space && !before_space;
+                //    ,       
+                const bool is_syntax = keep_query_syntax
+                    && ((c == '-' && (after_space || normalized[i - 1] == '-'))
+                        || (c == '"' && (after_space || normalized[i - 1] == '-' || before_space))
+                        || (c == '*' && before_space));
+                if (is_joiner || is_syntax)
+                {
+                    normalized[i] = c;
+                }
+            }
+            ++i;
+            continue;
+        }
+        const size_t length = GetValidUtf8SequenceLength(text.substr(i));
+        if (length == 0)
+        {
+            normalized[i] = text[i];
+            ++i;
+            continue;
+        }
+        const uint32_t code_point = DecodeUtf8(text.data() + i, length);
+        const uint32_t folded = FoldCodePoint(code_point);
+        if (folded == code_point)
+        {
+            std::copy(text.data() + i, text.data() + i + length, normalized.begin() + i);
+        }
+        else if (folded != ' ')
+        {
+            normalized[i] = static_cast<char>(0xC0 | (folded >> 6));
+            normalized[i + 1] = static_cast<char>(0x80 | (folded & 0x3F));
+        }
+        i += length;
+    }
+    return normalized;
 }
 
 struct Document 
@@ -69,11 +490,38 @@ struct Document
     int rating = 0;
 };
 
+//  :   ,    -   
+inline bool IsMoreRelevant(const Document& lhs, const Document& rhs)
+{
+    const double eps = 1e-6;
+    if (std::abs(lhs.relevance - rhs.relevance) < eps)
+    {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+//   .        
+template <typename StringContainer>
+std::set<std::string> MakeNormalizedWords(const StringContainer& strings, TextEncoding encoding)
+{
+    std::set<std::string> words;
+    for (const std::string& str : strings)
+    {
+        const std::string normalized = NormalizeText(str, encoding);
+        for (const Token& token : Tokenize(normalized))
+        {
+            words.emplace(token.text);
+        }
+    }
+    return words;
+}
+
 template <typename StringContainer>
 std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) 
 {
-    set<string> non_empty_strings;
-    for (const string& str : strings) 
+    std::set<std::string> non_empty_strings;
+    for (const std::string& str : strings) 
     {
         if (!str.empty()) 
         {
@@ -91,371 +539,5162 @@ enum class DocumentStatus
     REMOVED,
 };
 
-class SearchServer {
-public:    
+//   . Try-    ,   
+// std::invalid_argument    GetErrorMessage.    :   Expected  
+enum class SearchError
+{
+    NEGATIVE_DOCUMENT_ID,
+    DUPLICATE_DOCUMENT_ID,
+    INVALID_DOCUMENT_WORD,
+    QUERY_DOUBLE_MINUS,
+    QUERY_INVALID_WORD,
+    QUERY_SINGLE_MINUS,
+    QUERY_UNTERMINATED_PHRASE,
+    QUERY_EMPTY_PREFIX,
+};
 
-    template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words) : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+std::string GetErrorMessage(SearchError error)
+{
+    switch (error)
     {
-        
-        for (const string& word : MakeUniqueNonEmptyStrings(stop_words)) {
-            if (!IsValidWord(word)) {
-                throw invalid_argument("   "s);
-            }
-        }         
-        
+    case SearchError::NEGATIVE_DOCUMENT_ID:
+        return " ID  "s;
+    case SearchError::DUPLICATE_DOCUMENT_ID:
+        return "      ID"s;
+    case SearchError::INVALID_DOCUMENT_WORD:
+        return "   "s;
+    case SearchError::QUERY_DOUBLE_MINUS:
+        return "     "s;
+    case SearchError::QUERY_INVALID_WORD:
+        return "     "s;
+    case SearchError::QUERY_SINGLE_MINUS:
+        return "     "s;
+    case SearchError::QUERY_UNTERMINATED_PHRASE:
+        return "      "s;
+    case SearchError::QUERY_EMPTY_PREFIX:
+        return "    *  "s;
     }
+    return " "s;
+}
 
-    explicit SearchServer(const std::string& stop_words_text) : SearchServer(SplitIntoWords(stop_words_text))
+//    ,  std::expected  C++23.
+// GetError      
+template <typename Value>
+class [[nodiscard]] Expected
+{
+public:
+    Expected(Value value)
+        : value_(std::move(value))
     { }
 
-    void AddDocument(int document_id, const std::string& document, DocumentStatus status,
-        const std::vector<int>& ratings) 
+    Expected(SearchError error)
+        : error_(error)
+    { }
+
+    bool HasValue() const
     {
-        if (document_id < 0)  
-        {
-            throw std::invalid_argument(" ID  "s);
-        }
-        std::vector<std::string> words = SplitIntoWordsNoStop(document);
-       
-        if (documents_.count(document_id) > 0)
-        {
-            throw std::invalid_argument("      ID"s);
-        }
+        return value_.has_value();
+    }
+
+    explicit operator bool() const
+    {
+        return HasValue();
+    }
+
+    SearchError GetError() const
+    {
+        return error_.value();
+    }
+
+    Value& GetValue()
+    {
+        return value_.value();
+    }
+
+    const Value& GetValue() const
+    {
+        return value_.value();
+    }
+
+private:
+    std::optional<Value> value_;
+    std::optional<SearchError> error_;
+};
+
+template <>
+class [[nodiscard]] Expected<void>
+{
+public:
+    Expected() = default;
+
+    Expected(SearchError error)
+        : error_(error)
+    { }
+
+    bool HasValue() const
+    {
+        return !error_.has_value();
+    }
+
+    explicit operator bool() const
+    {
+        return HasValue();
+    }
+
+    SearchError GetError() const
+    {
+        return error_.value();
+    }
+
+private:
+    std::optional<SearchError> error_;
+};
+
+const size_t DOCUMENT_STATUS_COUNT = static_cast<size_t>(DocumentStatus::REMOVED) + 1;
+
+// ,   FindAllDocuments      .
+//    ,       
+struct DocumentStatusIs
+{
+    DocumentStatus status;
+
+    bool operator()(int, DocumentStatus document_status, int) const
+    {
+        return document_status == status;
+    }
+};
+
+struct DocumentRatingAtLeast
+{
+    int min_rating;
+
+    bool operator()(int, DocumentStatus, int rating) const
+    {
+        return rating >= min_rating;
+    }
+};
+
+#ifdef SEARCH_SERVER_TRACING
+//  .   -DSEARCH_SERVER_TRACING,    SEARCH_TRACE
+//            
+
+#define SEARCH_TRACE(...) __VA_ARGS__
+
+//     ,     operator new/delete
+thread_local size_t g_trace_allocation_count = 0;
+
+void* operator new(size_t size)
+{
+    ++g_trace_allocation_count;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
 
-        const double inv_word_count = 1.0 / words.size();
-        for (const std::string& word : words)
+//  :     malloc  free. GCC  
+//  free   new-       delete
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+enum class QueryStage
+{
+    PARSE,
+    POSTINGS,
+    MINUS_WORDS,
+    PHRASES,
+    COLLECT,
+    SORT,
+    TRUNCATE,
+};
+
+const size_t QUERY_STAGE_COUNT = static_cast<size_t>(QueryStage::TRUNCATE) + 1;
+
+const char* GetStageName(QueryStage stage)
+{
+    static const char* const names[QUERY_STAGE_COUNT] = { "parse", "postings", "minus words", "phrases", "collect", "sort", "truncate" };
+    return names[static_cast<size_t>(stage)];
+}
+
+struct QueryTrace
+{
+    std::string query;
+    std::array<std::chrono::nanoseconds, QUERY_STAGE_COUNT> stage_times{};
+    std::chrono::nanoseconds total_time{};
+    size_t postings_touched = 0;
+    size_t candidates_scored = 0;
+    size_t allocations = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, const QueryTrace& trace)
+{
+    out << "query \""s << trace.query << "\": total = "s << trace.total_time.count() << " ns"s;
+    for (size_t stage = 0; stage < QUERY_STAGE_COUNT; ++stage)
+    {
+        out << ", "s << GetStageName(static_cast<QueryStage>(stage)) << " = "s << trace.stage_times[stage].count() << " ns"s;
+    }
+    return out << ", postings = "s << trace.postings_touched
+        << ", candidates = "s << trace.candidates_scored
+        << ", allocations = "s << trace.allocations;
+}
+
+//      :   k    [2^(k-1), 2^k)
+class Log2Histogram
+{
+public:
+    void Add(uint64_t value)
+    {
+        size_t bucket = 0;
+        while (value >> bucket)
         {
-            word_to_document_freqs_[word][document_id] += inv_word_count;
+            ++bucket;
         }
-        documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
-        document_ids_.push_back(document_id);
-        
+        ++buckets_[bucket];
+        ++count_;
+        sum_ += value;
+        max_ = std::max(max_, value);
     }
 
-    template <typename DocumentPredicate>
-    std::vector<Document>FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const
+    uint64_t GetCount() const
     {
-         Query query = ParseQuery(raw_query);
-        auto matched_documents = FindAllDocuments(query, document_predicate);
-        const double eps = 1e-6;
+        return count_;
+    }
 
-        sort(matched_documents.begin(), matched_documents.end(), [&](const Document& lhs, const Document& rhs)
+    //   ,    
+    uint64_t GetQuantileBound(double quantile) const
+    {
+        const uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * count_));
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < buckets_.size(); ++bucket)
+        {
+            seen += buckets_[bucket];
+            if (seen >= rank && seen > 0)
             {
-            if (abs(lhs.relevance - rhs.relevance) < eps)
+                return std::min(max_, bucket == 0 ? 0 : (uint64_t{ 1 } << bucket) - 1);
+            }
+        }
+        return max_;
+    }
+
+    void Print(std::ostream& out, const std::string& name) const
+    {
+        out << "  "s << name << ": count = "s << count_
+            << ", mean = "s << (count_ > 0 ? sum_ / count_ : 0)
+            << ", p50 <= "s << GetQuantileBound(0.5)
+            << ", p90 <= "s << GetQuantileBound(0.9)
+            << ", p99 <= "s << GetQuantileBound(0.99)
+            << ", max = "s << max_ << std::endl;
+    }
+
+private:
+    std::array<uint64_t, 65> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+//        .
+//     ,   
+class QueryStatistics
+{
+public:
+    static const size_t MAX_SLOW_QUERY_COUNT = 100;
+
+    void SetSlowQueryThreshold(std::chrono::nanoseconds threshold)
+    {
+        std::lock_guard guard(mutex_);
+        slow_query_threshold_ = threshold;
+    }
+
+    void Record(const QueryTrace& trace)
+    {
+        std::lock_guard guard(mutex_);
+        for (size_t stage = 0; stage < QUERY_STAGE_COUNT; ++stage)
+        {
+            stage_histograms_[stage].Add(trace.stage_times[stage].count());
+        }
+        total_histogram_.Add(trace.total_time.count());
+        postings_histogram_.Add(trace.postings_touched);
+        candidates_histogram_.Add(trace.candidates_scored);
+        allocations_histogram_.Add(trace.allocations);
+        if (trace.total_time >= slow_query_threshold_)
+        {
+            if (slow_queries_.size() == MAX_SLOW_QUERY_COUNT)
+            {
+                slow_queries_.pop_front();
+            }
+            slow_queries_.push_back(trace);
+        }
+    }
+
+    std::deque<QueryTrace> GetSlowQueries() const
+    {
+        std::lock_guard guard(mutex_);
+        return slow_queries_;
+    }
+
+    //      ,  
+    void Reset()
+    {
+        std::lock_guard guard(mutex_);
+        for (Log2Histogram& histogram : stage_histograms_)
+        {
+            histogram = Log2Histogram();
+        }
+        total_histogram_ = Log2Histogram();
+        postings_histogram_ = Log2Histogram();
+        candidates_histogram_ = Log2Histogram();
+        allocations_histogram_ = Log2Histogram();
+        slow_queries_.clear();
+    }
+
+    void PrintHistograms(std::ostream& out) const
+    {
+        std::lock_guard guard(mutex_);
+        out << "Query statistics:"s << std::endl;
+        total_histogram_.Print(out, "total, ns"s);
+        for (size_t stage = 0; stage < QUERY_STAGE_COUNT; ++stage)
+        {
+            stage_histograms_[stage].Print(out, GetStageName(static_cast<QueryStage>(stage)) + ", ns"s);
+        }
+        postings_histogram_.Print(out, "postings touched"s);
+        candidates_histogram_.Print(out, "candidates scored"s);
+        allocations_histogram_.Print(out, "allocations"s);
+    }
+
+    void PrintSlowQueries(std::ostream& out) const
+    {
+        std::lock_guard guard(mutex_);
+        out << "Slow queries (>= "s << slow_query_threshold_.count() << " ns):"s << std::endl;
+        for (const QueryTrace& trace : slow_queries_)
+        {
+            out << "  "s << trace << std::endl;
+        }
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::chrono::nanoseconds slow_query_threshold_ = std::chrono::milliseconds(1);
+    std::array<Log2Histogram, QUERY_STAGE_COUNT> stage_histograms_;
+    Log2Histogram total_histogram_;
+    Log2Histogram postings_histogram_;
+    Log2Histogram candidates_histogram_;
+    Log2Histogram allocations_histogram_;
+    std::deque<QueryTrace> slow_queries_;
+};
+
+//   .     EnterStage      .
+//   (FindAllDocuments)      
+class QueryTracer
+{
+public:
+    QueryTracer(QueryStatistics& statistics, const std::string& query)
+        : statistics_(statistics)
+        , outer_(current_)
+        , start_(Clock::now())
+        , stage_start_(start_)
+        , allocations_start_(g_trace_allocation_count)
+    {
+        trace_.query = query;
+        current_ = this;
+    }
+
+    QueryTracer(const QueryTracer&) = delete;
+    QueryTracer& operator=(const QueryTracer&) = delete;
+
+    ~QueryTracer()
+    {
+        const auto now = Clock::now();
+        CloseStage(now);
+        trace_.total_time = now - start_;
+        trace_.allocations = g_trace_allocation_count - allocations_start_;
+        current_ = outer_;
+        statistics_.Record(trace_);
+    }
+
+    static void EnterStage(QueryStage stage)
+    {
+        if (current_)
+        {
+            const auto now = Clock::now();
+            current_->CloseStage(now);
+            current_->stage_ = stage;
+            current_->stage_start_ = now;
+        }
+    }
+
+    static void CountPostings(size_t count)
+    {
+        if (current_)
+        {
+            current_->trace_.postings_touched += count;
+        }
+    }
+
+    static void CountCandidates(size_t count)
+    {
+        if (current_)
+        {
+            current_->trace_.candidates_scored += count;
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void CloseStage(Clock::time_point now)
+    {
+        trace_.stage_times[static_cast<size_t>(stage_)] += now - stage_start_;
+    }
+
+    static thread_local QueryTracer* current_;
+
+    QueryStatistics& statistics_;
+    QueryTracer* outer_;
+    QueryTrace trace_;
+    QueryStage stage_ = QueryStage::PARSE;
+    Clock::time_point start_;
+    Clock::time_point stage_start_;
+    size_t allocations_start_;
+};
+
+thread_local QueryTracer* QueryTracer::current_ = nullptr;
+#else
+#define SEARCH_TRACE(...)
+#endif
+
+// ,     .   (   rebind-
+//    )   ,       
+template <typename Type>
+class CountingAllocator
+{
+public:
+    using value_type = Type;
+
+    CountingAllocator()
+        : allocated_bytes_(std::make_shared<size_t>(0))
+    { }
+
+    //      :     
+    CountingAllocator(const CountingAllocator&) noexcept = default;
+
+    template <typename Other>
+    CountingAllocator(const CountingAllocator<Other>& other) noexcept
+        : allocated_bytes_(other.allocated_bytes_)
+    { }
+
+    Type* allocate(size_t count)
+    {
+        Type* ptr = std::allocator<Type>().allocate(count);
+        *allocated_bytes_ += count * sizeof(Type);
+        return ptr;
+    }
+
+    void deallocate(Type* ptr, size_t count) noexcept
+    {
+        *allocated_bytes_ -= count * sizeof(Type);
+        std::allocator<Type>().deallocate(ptr, count);
+    }
+
+    size_t GetAllocatedBytes() const
+    {
+        return *allocated_bytes_;
+    }
+
+    template <typename Other>
+    bool operator==(const CountingAllocator<Other>& other) const noexcept
+    {
+        return allocated_bytes_ == other.allocated_bytes_;
+    }
+
+    template <typename Other>
+    bool operator!=(const CountingAllocator<Other>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+private:
+    template <typename Other>
+    friend class CountingAllocator;
+
+    std::shared_ptr<size_t> allocated_bytes_;
+};
+
+//    :          
+// 32-    .  -     .
+//            :  
+//         ,   .
+//      ,      - 
+//   ,       ,   
+class TermDictionary
+{
+public:
+    static const uint32_t NO_TERM = static_cast<uint32_t>(-1);
+
+    TermDictionary()
+        : offsets_(1, 0, CountingAllocator<uint32_t>(arena_.get_allocator()))
+        , slots_(CountingAllocator<Slot>(arena_.get_allocator()))
+        , sorted_terms_(CountingAllocator<uint32_t>(arena_.get_allocator()))
+        , pending_terms_(CountingAllocator<uint32_t>(arena_.get_allocator()))
+        , frequencies_(CountingAllocator<uint32_t>(arena_.get_allocator()))
+        , sorted_positions_(CountingAllocator<uint32_t>(arena_.get_allocator()))
+        , block_max_frequencies_(CountingAllocator<uint32_t>(arena_.get_allocator()))
+    {
+        pending_terms_.reserve(PENDING_TERM_COUNT);
+    }
+
+    uint32_t Find(std::string_view word) const
+    {
+        if (slots_.empty())
+        {
+            return NO_TERM;
+        }
+        const uint32_t hash = Hash(word);
+        for (size_t index = hash & (slots_.size() - 1);; index = (index + 1) & (slots_.size() - 1))
+        {
+            const Slot& slot = slots_[index];
+            if (slot.term == NO_TERM)
             {
-                return lhs.rating > rhs.rating;
+                return NO_TERM;
             }
-            else 
+            if (slot.hash == hash && GetTerm(slot.term) == word)
             {
-                return lhs.relevance > rhs.relevance;
+                return slot.term;
             }
-            });
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) 
+        }
+    }
+
+    //  ,    
+    uint32_t Intern(std::string_view word)
+    {
+        const uint32_t found = Find(word);
+        if (found != NO_TERM)
         {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+            return found;
+        }
+        if (pending_terms_.size() == PENDING_TERM_COUNT)
+        {
+            MergePendingTerms();
+        }
+        frequencies_.reserve(GetSize() + 1);
+        sorted_positions_.reserve(GetSize() + 1);
+        //     1/2
+        if ((GetSize() + 1) * 2 > slots_.size())
+        {
+            Rehash(std::max<size_t>(slots_.size() * 2, 16));
+        }
+        const uint32_t term = static_cast<uint32_t>(GetSize());
+        offsets_.push_back(static_cast<uint32_t>(arena_.size() + word.size()));
+        try
+        {
+            arena_.insert(arena_.end(), word.begin(), word.end());
+        }
+        catch (...)
+        {
+            offsets_.pop_back();
+            throw;
         }
-        return matched_documents;
+        PlaceSlot({ Hash(word), term });
+        pending_terms_.push_back(term);
+        frequencies_.push_back(0);
+        sorted_positions_.push_back(NO_POSITION);
+        return term;
     }
 
-   std::vector<Document>FindTopDocuments(const std::string& raw_query, DocumentStatus status) const
-   {
-        return FindTopDocuments(
-            raw_query,
-            [status](int document_id, DocumentStatus document_status, int rating)
+    void IncrementFrequency(uint32_t term)
+    {
+        const uint32_t frequency = ++frequencies_[term];
+        if (sorted_positions_[term] != NO_POSITION)
+        {
+            uint32_t& block_max = block_max_frequencies_[sorted_positions_[term] / FREQUENCY_BLOCK_SIZE];
+            block_max = std::max(block_max, frequency);
+        }
+    }
+
+    uint32_t GetFrequency(uint32_t term) const
+    {
+        return frequencies_[term];
+    }
+
+    //   terms   max_count   ,   prefix,  
+    // ,    -   .    ,
+    //         
+    void FindMostFrequent(std::string_view prefix, size_t max_count, std::vector<uint32_t>& terms) const
+    {
+        if (max_count == 0)
+        {
+            return;
+        }
+        const auto has_prefix = [this, prefix](uint32_t term)
+        {
+            return GetTerm(term).substr(0, prefix.size()) == prefix;
+        };
+        const auto is_more_frequent = [this](uint32_t lhs, uint32_t rhs)
+        {
+            return frequencies_[lhs] > frequencies_[rhs] || (frequencies_[lhs] == frequencies_[rhs] && GetTerm(lhs) < GetTerm(rhs));
+        };
+        //         
+        std::vector<uint32_t> best;
+        const auto offer = [&best, max_count, &is_more_frequent](uint32_t term)
+        {
+            if (best.size() < max_count)
+            {
+                best.push_back(term);
+                std::push_heap(best.begin(), best.end(), is_more_frequent);
+            }
+            else if (is_more_frequent(term, best.front()))
+            {
+                std::pop_heap(best.begin(), best.end(), is_more_frequent);
+                best.back() = term;
+                std::push_heap(best.begin(), best.end(), is_more_frequent);
+            }
+        };
+        for (const uint32_t term : pending_terms_)
+        {
+            if (has_prefix(term))
+            {
+                offer(term);
+            }
+        }
+
+        const auto first = std::lower_bound(sorted_terms_.begin(), sorted_terms_.end(), prefix,
+            [this](uint32_t term, std::string_view value)
             {
-                return document_status == status;
+                return GetTerm(term) < value;
             });
+        const size_t first_position = first - sorted_terms_.begin();
+        const size_t last_position = std::partition_point(first, sorted_terms_.end(), has_prefix) - sorted_terms_.begin();
+        const auto offer_range = [this, &offer](size_t begin, size_t end)
+        {
+            for (size_t position = begin; position < end; ++position)
+            {
+                offer(sorted_terms_[position]);
+            }
+        };
+        //       ,  -    
+        const size_t first_block = (first_position + FREQUENCY_BLOCK_SIZE - 1) / FREQUENCY_BLOCK_SIZE;
+        const size_t last_block = last_position / FREQUENCY_BLOCK_SIZE;
+        if (first_block >= last_block)
+        {
+            offer_range(first_position, last_position);
+        }
+        else
+        {
+            offer_range(first_position, first_block * FREQUENCY_BLOCK_SIZE);
+            offer_range(last_block * FREQUENCY_BLOCK_SIZE, last_position);
+            std::vector<uint32_t> blocks(last_block - first_block);
+            std::iota(blocks.begin(), blocks.end(), static_cast<uint32_t>(first_block));
+            std::sort(blocks.begin(), blocks.end(), [this](uint32_t lhs, uint32_t rhs)
+                {
+                    return block_max_frequencies_[lhs] > block_max_frequencies_[rhs]
+                        || (block_max_frequencies_[lhs] == block_max_frequencies_[rhs] && lhs < rhs);
+                });
+            for (const uint32_t block : blocks)
+            {
+                //      block_max        
+                if (best.size() == max_count)
+                {
+                    const uint32_t worst = best.front();
+                    const uint32_t block_max = block_max_frequencies_[block];
+                    if (block_max < frequencies_[worst]
+                        || (block_max == frequencies_[worst] && GetTerm(sorted_terms_[block * FREQUENCY_BLOCK_SIZE]) > GetTerm(worst)))
+                    {
+                        break;
+                    }
+                }
+                offer_range(block * FREQUENCY_BLOCK_SIZE, (block + 1) * FREQUENCY_BLOCK_SIZE);
+            }
+        }
+        std::sort_heap(best.begin(), best.end(), is_more_frequent);
+        terms.insert(terms.end(), best.begin(), best.end());
+    }
+
+    //     
+    std::string_view GetTerm(uint32_t term) const
+    {
+        return std::string_view(arena_.data() + offsets_[term], offsets_[term + 1] - offsets_[term]);
+    }
+
+    size_t GetSize() const
+    {
+        return offsets_.size() - 1;
+    }
+
+    size_t GetAllocatedBytes() const
+    {
+        return arena_.get_allocator().GetAllocatedBytes();
+    }
+
+private:
+    //    .     ,
+    //       1/PENDING_TERM_COUNT  
+    static const size_t PENDING_TERM_COUNT = 256;
+    static constexpr size_t FREQUENCY_BLOCK_SIZE = 64;
+    static constexpr uint32_t NO_POSITION = static_cast<uint32_t>(-1);
+
+    struct Slot
+    {
+        uint32_t hash = 0;
+        uint32_t term = NO_TERM;
+    };
+
+    static uint32_t Hash(std::string_view word)
+    {
+        return static_cast<uint32_t>(std::hash<std::string_view>{}(word));
+    }
+
+    void PlaceSlot(const Slot& slot)
+    {
+        size_t index = slot.hash & (slots_.size() - 1);
+        while (slots_[index].term != NO_TERM)
+        {
+            index = (index + 1) & (slots_.size() - 1);
+        }
+        slots_[index] = slot;
+    }
+
+    void Rehash(size_t slot_count)
+    {
+        std::vector<Slot, CountingAllocator<Slot>> old_slots(slot_count, Slot{}, slots_.get_allocator());
+        old_slots.swap(slots_);
+        for (const Slot& slot : old_slots)
+        {
+            if (slot.term != NO_TERM)
+            {
+                PlaceSlot(slot);
+            }
+        }
+    }
+
+    void MergePendingTerms()
+    {
+        const auto is_less = [this](uint32_t lhs, uint32_t rhs)
+        {
+            return GetTerm(lhs) < GetTerm(rhs);
+        };
+        std::sort(pending_terms_.begin(), pending_terms_.end(), is_less);
+        const size_t sorted_count = sorted_terms_.size();
+        sorted_terms_.insert(sorted_terms_.end(), pending_terms_.begin(), pending_terms_.end());
+        std::inplace_merge(sorted_terms_.begin(), sorted_terms_.begin() + sorted_count, sorted_terms_.end(), is_less);
+        pending_terms_.clear();
+
+        block_max_frequencies_.assign((sorted_terms_.size() + FREQUENCY_BLOCK_SIZE - 1) / FREQUENCY_BLOCK_SIZE, 0);
+        for (size_t position = 0; position < sorted_terms_.size(); ++position)
+        {
+            const uint32_t term = sorted_terms_[position];
+            sorted_positions_[term] = static_cast<uint32_t>(position);
+            uint32_t& block_max = block_max_frequencies_[position / FREQUENCY_BLOCK_SIZE];
+            block_max = std::max(block_max, frequencies_[term]);
+        }
+    }
+
+    //   ,  i  [offsets_[i], offsets_[i + 1])
+    std::vector<char, CountingAllocator<char>> arena_;
+    std::vector<uint32_t, CountingAllocator<uint32_t>> offsets_;
+    std::vector<Slot, CountingAllocator<Slot>> slots_;
+    //  ,  pending_terms_,    
+    std::vector<uint32_t, CountingAllocator<uint32_t>> sorted_terms_;
+    std::vector<uint32_t, CountingAllocator<uint32_t>> pending_terms_;
+    std::vector<uint32_t, CountingAllocator<uint32_t>> frequencies_;
+    //    sorted_terms_, NO_POSITION    pending_terms_
+    std::vector<uint32_t, CountingAllocator<uint32_t>> sorted_positions_;
+    //     sorted_terms_   [i * FREQUENCY_BLOCK_SIZE, (i + 1) * FREQUENCY_BLOCK_SIZE)
+    std::vector<uint32_t, CountingAllocator<uint32_t>> block_max_frequencies_;
+};
+
+//  -    ,     max_distance,
+//  max_distance + 1.  -  DecodeSymbols,    UTF-8   
+inline int ComputeEditDistance(std::u32string_view lhs, std::u32string_view rhs, int max_distance)
+{
+    if (std::max(lhs.size(), rhs.size()) - std::min(lhs.size(), rhs.size()) > static_cast<size_t>(max_distance))
+    {
+        return max_distance + 1;
+    }
+    //        lhs  rhs
+    std::vector<int> before_previous(rhs.size() + 1);
+    std::vector<int> previous(rhs.size() + 1);
+    std::vector<int> current(rhs.size() + 1);
+    for (size_t j = 0; j <= rhs.size(); ++j)
+    {
+        previous[j] = static_cast<int>(j);
+    }
+    for (size_t i = 1; i <= lhs.size(); ++i)
+    {
+        current[0] = static_cast<int>(i);
+        int row_min = current[0];
+        for (size_t j = 1; j <= rhs.size(); ++j)
+        {
+            const int cost = lhs[i - 1] == rhs[j - 1] ? 0 : 1;
+            current[j] = std::min({ previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost });
+            if (i > 1 && j > 1 && lhs[i - 1] == rhs[j - 2] && lhs[i - 2] == rhs[j - 1])
+            {
+                current[j] = std::min(current[j], before_previous[j - 2] + 1);
+            }
+            row_min = std::min(row_min, current[j]);
+        }
+        //     ,     
+        if (row_min > max_distance)
+        {
+            return max_distance + 1;
+        }
+        std::swap(before_previous, previous);
+        std::swap(previous, current);
+    }
+    return std::min(previous[rhs.size()], max_distance + 1);
+}
+
+//       ,   SymSpell.    
+//  ,    PREFIX_LENGTH  (DecodeSymbols)    max_edit_distance  .
+//       max_edit_distance    ,  
+//     -;     .
+//       entries_,        
+class DeletionIndex
+{
+public:
+    static const size_t PREFIX_LENGTH = 7;
+
+    explicit DeletionIndex(int max_edit_distance = 0)
+        : max_edit_distance_(max_edit_distance)
+        , entries_(CountingAllocator<Entry>(slots_.get_allocator()))
+    { }
+
+    int GetMaxEditDistance() const
+    {
+        return max_edit_distance_;
+    }
+
+    void Add(uint32_t term, std::string_view word)
+    {
+        if (max_edit_distance_ == 0)
+        {
+            return;
+        }
+        for (const uint32_t hash : GetDeletionHashes(DecodeSymbols(word)))
+        {
+            if ((slot_count_ + 1) * 2 > slots_.size())
+            {
+                Rehash(std::max<size_t>(slots_.size() * 2, 16));
+            }
+            Slot& slot = FindSlot(hash);
+            if (slot.first_entry == NO_ENTRY)
+            {
+                slot.hash = hash;
+                ++slot_count_;
+            }
+            entries_.push_back({ term, slot.first_entry });
+            slot.first_entry = static_cast<uint32_t>(entries_.size() - 1);
+        }
+    }
+
+    //   terms     word ,    max_count.
+    //   , -       
+    void FindCandidates(std::string_view word, size_t max_count, std::vector<uint32_t>& terms) const
+    {
+        if (slots_.empty())
+        {
+            return;
+        }
+        size_t count = 0;
+        for (const uint32_t hash : GetDeletionHashes(DecodeSymbols(word)))
+        {
+            for (uint32_t entry = FindSlot(hash).first_entry; entry != NO_ENTRY && count < max_count; entry = entries_[entry].next)
+            {
+                terms.push_back(entries_[entry].term);
+                ++count;
+            }
+        }
+    }
+
+    size_t GetAllocatedBytes() const
+    {
+        return slots_.get_allocator().GetAllocatedBytes();
+    }
+
+private:
+    static const uint32_t NO_ENTRY = static_cast<uint32_t>(-1);
+
+    struct Slot
+    {
+        uint32_t hash = 0;
+        //      , NO_ENTRY   
+        uint32_t first_entry = NO_ENTRY;
+    };
+
+    struct Entry
+    {
+        uint32_t term;
+        uint32_t next;
+    };
+
+    //  ,    symbols    max_edit_distance_ ,  
+    std::vector<uint32_t> GetDeletionHashes(std::u32string_view symbols) const
+    {
+        std::vector<std::u32string> deletions{ std::u32string(symbols.substr(0, PREFIX_LENGTH)) };
+        size_t level_begin = 0;
+        for (int distance = 0; distance < max_edit_distance_; ++distance)
+        {
+            const size_t level_end = deletions.size();
+            for (size_t i = level_begin; i < level_end; ++i)
+            {
+                for (size_t position = 0; position < deletions[i].size(); ++position)
+                {
+                    std::u32string deletion = deletions[i];
+                    deletion.erase(position, 1);
+                    deletions.push_back(std::move(deletion));
+                }
+            }
+            level_begin = level_end;
+        }
+        std::vector<uint32_t> hashes;
+        hashes.reserve(deletions.size());
+        for (const std::u32string& deletion : deletions)
+        {
+            hashes.push_back(static_cast<uint32_t>(std::hash<std::u32string_view>{}(deletion)));
+        }
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+        return hashes;
+    }
+
+    //       ,    
+    Slot& FindSlot(uint32_t hash)
+    {
+        size_t index = hash & (slots_.size() - 1);
+        while (slots_[index].first_entry != NO_ENTRY && slots_[index].hash != hash)
+        {
+            index = (index + 1) & (slots_.size() - 1);
+        }
+        return slots_[index];
+    }
+
+    const Slot& FindSlot(uint32_t hash) const
+    {
+        return const_cast<DeletionIndex*>(this)->FindSlot(hash);
+    }
+
+    void Rehash(size_t slot_count)
+    {
+        std::vector<Slot, CountingAllocator<Slot>> old_slots(slot_count, Slot{}, slots_.get_allocator());
+        old_slots.swap(slots_);
+        for (const Slot& slot : old_slots)
+        {
+            if (slot.first_entry != NO_ENTRY)
+            {
+                FindSlot(slot.hash) = slot;
+            }
+        }
+    }
+
+    int max_edit_distance_;
+    size_t slot_count_ = 0;
+    std::vector<Slot, CountingAllocator<Slot>> slots_;
+    std::vector<Entry, CountingAllocator<Entry>> entries_;
+};
+
+//  -.     ,     
+// -   hash-and-displace:    ,    
+//    ,      .   -  ,
+//         
+class StopWordFilter
+{
+public:
+    template <typename StringContainer>
+    explicit StopWordFilter(const StringContainer& words)
+        : displacements_(CountingAllocator<uint32_t>(arena_.get_allocator()))
+        , slots_(CountingAllocator<Slot>(arena_.get_allocator()))
+    {
+        std::vector<std::string_view> unique_words;
+        for (const auto& word : words)
+        {
+            if (!word.empty())
+            {
+                unique_words.emplace_back(word.data(), word.size());
+            }
+        }
+        std::sort(unique_words.begin(), unique_words.end());
+        unique_words.erase(std::unique(unique_words.begin(), unique_words.end()), unique_words.end());
+
+        std::vector<Slot> word_slots;
+        for (const std::string_view word : unique_words)
+        {
+            word_slots.push_back({ static_cast<uint32_t>(arena_.size()), static_cast<uint32_t>(word.size()) });
+            arena_.insert(arena_.end(), word.begin(), word.end());
+            length_mask_ |= uint64_t{ 1 } << std::min<size_t>(word.size(), 63);
+        }
+
+        size_t slot_count = 1;
+        while (slot_count < 2 * word_slots.size())
+        {
+            slot_count *= 2;
+        }
+        //           ,
+        //       
+        for (uint64_t attempt = 0; !TryBuild(word_slots, slot_count); ++attempt)
+        {
+            hash_seed_ = attempt + 1;
+            if (attempt % 4 == 3)
+            {
+                slot_count *= 2;
+            }
+        }
+    }
+
+    bool Contains(std::string_view word) const
+    {
+        if (((length_mask_ >> std::min<size_t>(word.size(), 63)) & 1) == 0)
+        {
+            return false;
+        }
+        const uint64_t hash = Hash(word);
+        const Slot& slot = slots_[GetSlot(hash, displacements_[(hash >> 32) % displacements_.size()])];
+        return slot.length == word.size() && std::memcmp(arena_.data() + slot.offset, word.data(), word.size()) == 0;
+    }
+
+    size_t GetAllocatedBytes() const
+    {
+        return arena_.get_allocator().GetAllocatedBytes();
+    }
+
+private:
+    //      :        
+    static const size_t WORDS_PER_BUCKET = 3;
+    static const uint32_t MAX_DISPLACEMENT = 1 << 16;
+
+    //     , -   
+    struct Slot
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    uint64_t Hash(std::string_view word) const
+    {
+        uint64_t hash = 14695981039346656037ull ^ (hash_seed_ * 0x9E3779B97F4A7C15ull);
+        for (const char c : word)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        //   splitmix64,       
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    size_t GetSlot(uint64_t hash, uint32_t displacement) const
+    {
+        uint64_t mixed = (hash ^ (displacement * 0xC2B2AE3D27D4EB4Full)) * 0x165667B19E3779F9ull;
+        mixed ^= mixed >> 29;
+        return static_cast<size_t>(mixed) & (slots_.size() - 1);
+    }
+
+    bool TryBuild(const std::vector<Slot>& word_slots, size_t slot_count)
+    {
+        const size_t bucket_count = word_slots.size() / WORDS_PER_BUCKET + 1;
+        displacements_.assign(bucket_count, 0);
+        slots_.assign(slot_count, Slot{});
+
+        std::vector<std::vector<std::pair<uint64_t, Slot>>> buckets(bucket_count);
+        for (const Slot& slot : word_slots)
+        {
+            const uint64_t hash = Hash(std::string_view(arena_.data() + slot.offset, slot.length));
+            buckets[(hash >> 32) % bucket_count].push_back({ hash, slot });
+        }
+        //    ,    
+        std::vector<size_t> order(bucket_count);
+        for (size_t bucket = 0; bucket < bucket_count; ++bucket)
+        {
+            order[bucket] = bucket;
+        }
+        std::sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs)
+            {
+                return buckets[lhs].size() > buckets[rhs].size();
+            });
+
+        std::vector<size_t> placed;
+        for (const size_t bucket : order)
+        {
+            bool is_placed = buckets[bucket].empty();
+            for (uint32_t displacement = 0; !is_placed && displacement < MAX_DISPLACEMENT; ++displacement)
+            {
+                placed.clear();
+                is_placed = true;
+                for (const auto& [hash, slot] : buckets[bucket])
+                {
+                    const size_t index = GetSlot(hash, displacement);
+                    if (slots_[index].length != 0 || std::find(placed.begin(), placed.end(), index) != placed.end())
+                    {
+                        is_placed = false;
+                        break;
+                    }
+                    placed.push_back(index);
+                }
+                if (is_placed)
+                {
+                    displacements_[bucket] = displacement;
+                    for (size_t i = 0; i < placed.size(); ++i)
+                    {
+                        slots_[placed[i]] = buckets[bucket][i].second;
+                    }
+                }
+            }
+            if (!is_placed)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<char, CountingAllocator<char>> arena_;
+    std::vector<uint32_t, CountingAllocator<uint32_t>> displacements_;
+    std::vector<Slot, CountingAllocator<Slot>> slots_;
+    //  k ,   -  k (63 -  63  )
+    uint64_t length_mask_ = 0;
+    uint64_t hash_seed_ = 0;
+};
+
+//   ,   .      -,
+//  -   
+struct MemoryStats
+{
+    size_t stop_words = 0;
+    size_t dictionary = 0;
+    size_t postings = 0;
+    size_t positions = 0;
+    size_t documents = 0;
+    size_t document_ids = 0;
+
+    size_t GetTotal() const
+    {
+        return stop_words + dictionary + postings + positions + documents + document_ids;
+    }
+};
+
+//        Roaring.    
+//  65536,     16 :    -  ,
+//   - .    
+class DocumentBitmap
+{
+public:
+    static const size_t NPOS = static_cast<size_t>(-1);
+
+    void Set(size_t ordinal, bool value)
+    {
+        const uint32_t key = static_cast<uint32_t>(ordinal >> CHUNK_BITS);
+        const uint16_t low = static_cast<uint16_t>(ordinal);
+        auto chunk = FindChunk(key);
+        if (value)
+        {
+            if (chunk == chunks_.end() || chunk->key != key)
+            {
+                chunk = chunks_.insert(chunk, Chunk(key, chunks_.get_allocator()));
+            }
+            chunk->Insert(low);
+        }
+        else if (chunk != chunks_.end() && chunk->key == key)
+        {
+            chunk->Erase(low);
+            if (chunk->count == 0)
+            {
+                chunks_.erase(chunk);
+            }
+        }
+    }
+
+    bool Test(size_t ordinal) const
+    {
+        const uint32_t key = static_cast<uint32_t>(ordinal >> CHUNK_BITS);
+        const auto chunk = FindChunk(key);
+        return chunk != chunks_.end() && chunk->key == key && chunk->Contains(static_cast<uint16_t>(ordinal));
+    }
+
+    //    ,   ordinal,  NPOS
+    size_t NextSetBit(size_t ordinal) const
+    {
+        const uint32_t key = static_cast<uint32_t>(ordinal >> CHUNK_BITS);
+        auto chunk = FindChunk(key);
+        if (chunk != chunks_.end() && chunk->key == key)
+        {
+            const size_t low = chunk->NextSetBit(static_cast<uint16_t>(ordinal));
+            if (low != NPOS)
+            {
+                return (size_t{ key } << CHUNK_BITS) | low;
+            }
+            ++chunk;
+        }
+        if (chunk == chunks_.end())
+        {
+            return NPOS;
+        }
+        return (size_t{ chunk->key } << CHUNK_BITS) | chunk->NextSetBit(0);
+    }
+
+    size_t GetCount() const
+    {
+        size_t count = 0;
+        for (const Chunk& chunk : chunks_)
+        {
+            count += chunk.count;
+        }
+        return count;
+    }
+
+    size_t GetAllocatedBytes() const
+    {
+        return chunks_.get_allocator().GetAllocatedBytes();
+    }
+
+private:
+    static const size_t CHUNK_BITS = 16;
+    static const size_t WORD_COUNT = (size_t{ 1 } << CHUNK_BITS) / 64;
+    //   4096    ,    (8 ).
+    //       ,     
+    static const size_t MAX_ARRAY_SIZE = 4096;
+    static const size_t MIN_BITS_SIZE = MAX_ARRAY_SIZE / 2;
+
+    struct Chunk
+    {
+        template <typename Allocator>
+        Chunk(uint32_t key, const Allocator& allocator)
+            : key(key)
+            , values(CountingAllocator<uint16_t>(allocator))
+            , bits(CountingAllocator<uint64_t>(allocator))
+        { }
+
+        bool IsBits() const
+        {
+            return !bits.empty();
+        }
+
+        bool Contains(uint16_t low) const
+        {
+            if (IsBits())
+            {
+                return (bits[low / 64] >> (low % 64)) & 1;
+            }
+            return std::binary_search(values.begin(), values.end(), low);
+        }
+
+        size_t NextSetBit(uint16_t low) const
+        {
+            if (!IsBits())
+            {
+                const auto it = std::lower_bound(values.begin(), values.end(), low);
+                return it == values.end() ? NPOS : *it;
+            }
+            size_t word = low / 64;
+            uint64_t word_bits = bits[word] & (~uint64_t{ 0 } << (low % 64));
+            while (word_bits == 0)
+            {
+                if (++word == WORD_COUNT)
+                {
+                    return NPOS;
+                }
+                word_bits = bits[word];
+            }
+            return word * 64 + CountTrailingZeros(word_bits);
+        }
+
+        void Insert(uint16_t low)
+        {
+            if (IsBits())
+            {
+                uint64_t& word = bits[low / 64];
+                const uint64_t mask = uint64_t{ 1 } << (low % 64);
+                count += (word & mask) ? 0 : 1;
+                word |= mask;
+                return;
+            }
+            const auto it = std::lower_bound(values.begin(), values.end(), low);
+            if (it != values.end() && *it == low)
+            {
+                return;
+            }
+            if (values.size() < MAX_ARRAY_SIZE)
+            {
+                values.insert(it, low);
+                ++count;
+                return;
+            }
+            bits.assign(WORD_COUNT, 0);
+            for (const uint16_t value : values)
+            {
+                bits[value / 64] |= uint64_t{ 1 } << (value % 64);
+            }
+            values.clear();
+            values.shrink_to_fit();
+            Insert(low);
+        }
+
+        void Erase(uint16_t low)
+        {
+            if (!IsBits())
+            {
+                const auto it = std::lower_bound(values.begin(), values.end(), low);
+                if (it != values.end() && *it == low)
+                {
+                    values.erase(it);
+                    --count;
+                }
+                return;
+            }
+            uint64_t& word = bits[low / 64];
+            const uint64_t mask = uint64_t{ 1 } << (low % 64);
+            count -= (word & mask) ? 1 : 0;
+            word &= ~mask;
+            if (count < MIN_BITS_SIZE)
+            {
+                ShrinkToArray();
+            }
+        }
+
+        //        
+        void ShrinkToArray() noexcept
+        {
+            try
+            {
+                values.reserve(count);
+            }
+            catch (const std::bad_alloc&)
+            {
+                return;
+            }
+            for (size_t word = 0; word < WORD_COUNT; ++word)
+            {
+                for (uint64_t word_bits = bits[word]; word_bits != 0; word_bits &= word_bits - 1)
+                {
+                    values.push_back(static_cast<uint16_t>(word * 64 + CountTrailingZeros(word_bits)));
+                }
+            }
+            bits.clear();
+            bits.shrink_to_fit();
+        }
+
+        uint32_t key;
+        size_t count = 0;
+        std::vector<uint16_t, CountingAllocator<uint16_t>> values;
+        std::vector<uint64_t, CountingAllocator<uint64_t>> bits;
+    };
+
+    using Chunks = std::vector<Chunk, CountingAllocator<Chunk>>;
+
+    Chunks::iterator FindChunk(uint32_t key)
+    {
+        return std::lower_bound(chunks_.begin(), chunks_.end(), key, [](const Chunk& chunk, uint32_t value)
+            {
+                return chunk.key < value;
+            });
+    }
+
+    Chunks::const_iterator FindChunk(uint32_t key) const
+    {
+        return std::lower_bound(chunks_.begin(), chunks_.end(), key, [](const Chunk& chunk, uint32_t value)
+            {
+                return chunk.key < value;
+            });
+    }
+
+    Chunks chunks_;
+};
+
+//    :    ( -  )   
+// ,  7   ,   -  
+struct EncodedPositions
+{
+    const uint8_t* first = nullptr;
+    const uint8_t* last = nullptr;
+};
+
+template <typename ByteContainer>
+void EncodePositions(const uint32_t* first, const uint32_t* last, ByteContainer& bytes)
+{
+    uint32_t previous = 0;
+    for (; first != last; ++first)
+    {
+        uint32_t delta = *first - previous;
+        previous = *first;
+        while (delta >= 0x80)
+        {
+            bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+            delta >>= 7;
+        }
+        bytes.push_back(static_cast<uint8_t>(delta));
+    }
+}
+
+inline void DecodePositions(EncodedPositions encoded, std::vector<uint32_t>& positions)
+{
+    positions.clear();
+    uint32_t position = 0;
+    const uint8_t* byte = encoded.first;
+    while (byte != encoded.last)
+    {
+        uint32_t delta = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            delta |= static_cast<uint32_t>(*byte & 0x7F) << shift;
+            if ((*byte++ & 0x80) == 0)
+            {
+                break;
+            }
+        }
+        position += delta;
+        positions.push_back(position);
+    }
+}
+
+//   :    ,    
+//    .      
+class FrozenSegment
+{
+public:
+    using Posting = std::pair<int, double>;
+
+    class PostingRange
+    {
+    public:
+        PostingRange(const Posting* first, const Posting* last)
+            : first_(first)
+            , last_(last)
+        { }
+
+        const Posting* begin() const
+        {
+            return first_;
+        }
+
+        const Posting* end() const
+        {
+            return last_;
+        }
+
+        size_t size() const
+        {
+            return last_ - first_;
+        }
+
+    private:
+        const Posting* first_;
+        const Posting* last_;
+    };
+
+    //    : term_postings[term]     ,
+    // get_positions(term, ordinal)  EncodedPositions   
+    template <typename TermPostings, typename GetPositions>
+    FrozenSegment(const TermPostings& term_postings, GetPositions get_positions, int first_ordinal, int end_ordinal,
+        bool impact_ordered)
+        : first_ordinal_(first_ordinal)
+        , end_ordinal_(end_ordinal)
+        , impact_ordered_(impact_ordered)
+        , terms_(CountingAllocator<uint32_t>(term_offsets_.get_allocator()))
+        , postings_(CountingAllocator<Posting>(term_offsets_.get_allocator()))
+        , impact_order_(CountingAllocator<uint32_t>(term_offsets_.get_allocator()))
+        , term_position_offsets_(CountingAllocator<size_t>(position_offsets_.get_allocator()))
+        , positions_(CountingAllocator<uint8_t>(position_offsets_.get_allocator()))
+    {
+        size_t term_count = 0;
+        size_t posting_count = 0;
+        for (const auto& postings : term_postings)
+        {
+            term_count += postings.empty() ? 0 : 1;
+            posting_count += postings.size();
+        }
+        terms_.reserve(term_count);
+        term_offsets_.reserve(term_count + 1);
+        term_position_offsets_.reserve(term_count + 1);
+        postings_.reserve(posting_count);
+        position_offsets_.reserve(posting_count);
+        term_offsets_.push_back(0);
+        term_position_offsets_.push_back(0);
+        for (uint32_t term = 0; term < term_postings.size(); ++term)
+        {
+            const auto& postings = term_postings[term];
+            if (postings.empty())
+            {
+                continue;
+            }
+            terms_.push_back(term);
+            postings_.insert(postings_.end(), postings.begin(), postings.end());
+            term_offsets_.push_back(postings_.size());
+            for (const auto& [ordinal, _] : postings)
+            {
+                const EncodedPositions encoded = get_positions(term, ordinal);
+                position_offsets_.push_back(static_cast<uint32_t>(positions_.size() - term_position_offsets_.back()));
+                positions_.insert(positions_.end(), encoded.first, encoded.last);
+            }
+            term_position_offsets_.push_back(positions_.size());
+        }
+        if (impact_ordered_)
+        {
+            BuildImpactOrder();
+        }
+    }
+
+    //   ,     .
+    //     ,      
+    explicit FrozenSegment(const std::vector<std::shared_ptr<const FrozenSegment>>& segments)
+        : first_ordinal_(segments.front()->first_ordinal_)
+        , end_ordinal_(segments.back()->end_ordinal_)
+        , impact_ordered_(segments.front()->impact_ordered_)
+        , terms_(CountingAllocator<uint32_t>(term_offsets_.get_allocator()))
+        , postings_(CountingAllocator<Posting>(term_offsets_.get_allocator()))
+        , impact_order_(CountingAllocator<uint32_t>(term_offsets_.get_allocator()))
+        , term_position_offsets_(CountingAllocator<size_t>(position_offsets_.get_allocator()))
+        , positions_(CountingAllocator<uint8_t>(position_offsets_.get_allocator()))
+    {
+        std::vector<uint32_t> terms;
+        size_t posting_count = 0;
+        size_t position_byte_count = 0;
+        for (const auto& segment : segments)
+        {
+            terms.insert(terms.end(), segment->terms_.begin(), segment->terms_.end());
+            posting_count += segment->postings_.size();
+            position_byte_count += segment->positions_.size();
+            level_ = std::max(level_, segment->level_ + 1);
+        }
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+        terms_.assign(terms.begin(), terms.end());
+        term_offsets_.reserve(terms_.size() + 1);
+        term_position_offsets_.reserve(terms_.size() + 1);
+        postings_.reserve(posting_count);
+        position_offsets_.reserve(posting_count);
+        positions_.reserve(position_byte_count);
+        term_offsets_.push_back(0);
+        term_position_offsets_.push_back(0);
+        // cursors[i] -     terms_   i
+        std::vector<size_t> cursors(segments.size(), 0);
+        for (const uint32_t term : terms_)
+        {
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                const FrozenSegment& segment = *segments[i];
+                const size_t index = cursors[i];
+                if (index == segment.terms_.size() || segment.terms_[index] != term)
+                {
+                    continue;
+                }
+                ++cursors[i];
+                const size_t first = segment.term_offsets_[index];
+                const size_t last = segment.term_offsets_[index + 1];
+                postings_.insert(postings_.end(), segment.postings_.begin() + first, segment.postings_.begin() + last);
+                //        ,  
+                const uint32_t shift = static_cast<uint32_t>(positions_.size() - term_position_offsets_.back());
+                for (size_t posting = first; posting < last; ++posting)
+                {
+                    position_offsets_.push_back(segment.position_offsets_[posting] + shift);
+                }
+                positions_.insert(positions_.end(), segment.positions_.begin() + segment.term_position_offsets_[index],
+                    segment.positions_.begin() + segment.term_position_offsets_[index + 1]);
+            }
+            term_offsets_.push_back(postings_.size());
+            term_position_offsets_.push_back(positions_.size());
+        }
+        if (impact_ordered_)
+        {
+            BuildImpactOrder();
+        }
+    }
+
+    PostingRange GetPostings(uint32_t term) const
+    {
+        const size_t index = FindTerm(term);
+        if (index == NO_TERM)
+        {
+            return { nullptr, nullptr };
+        }
+        return { postings_.data() + term_offsets_[index], postings_.data() + term_offsets_[index + 1] };
+    }
+
+    //     GetPostings(term)   .
+    // nullptr,       
+    const uint32_t* GetImpactOrder(uint32_t term) const
+    {
+        const size_t index = impact_ordered_ ? FindTerm(term) : NO_TERM;
+        if (index == NO_TERM)
+        {
+            return nullptr;
+        }
+        return impact_order_.data() + term_offsets_[index];
+    }
+
+    bool Contains(uint32_t term, int ordinal) const
+    {
+        const PostingRange range = GetPostings(term);
+        return std::binary_search(range.begin(), range.end(), Posting{ ordinal, 0.0 }, ComparePostings);
+    }
+
+    //  ,     
+    EncodedPositions GetPositions(uint32_t term, int ordinal) const
+    {
+        const size_t term_index = FindTerm(term);
+        if (term_index == NO_TERM)
+        {
+            return {};
+        }
+        const Posting* range_first = postings_.data() + term_offsets_[term_index];
+        const Posting* range_last = postings_.data() + term_offsets_[term_index + 1];
+        const Posting* posting = std::lower_bound(range_first, range_last, Posting{ ordinal, 0.0 }, ComparePostings);
+        if (posting == range_last || posting->first != ordinal)
+        {
+            return {};
+        }
+        const size_t index = posting - postings_.data();
+        const size_t term_base = term_position_offsets_[term_index];
+        const size_t first = term_base + position_offsets_[index];
+        const size_t last = posting + 1 < range_last ? term_base + position_offsets_[index + 1] : term_position_offsets_[term_index + 1];
+        return { positions_.data() + first, positions_.data() + last };
+    }
+
+    static bool ComparePostings(const Posting& lhs, const Posting& rhs)
+    {
+        return lhs.first < rhs.first;
+    }
+
+    int GetFirstOrdinal() const
+    {
+        return first_ordinal_;
+    }
+
+    int GetEndOrdinal() const
+    {
+        return end_ordinal_;
+    }
+
+    //       0,       
+    int GetLevel() const
+    {
+        return level_;
+    }
+
+    size_t GetAllocatedBytes() const
+    {
+        return term_offsets_.get_allocator().GetAllocatedBytes();
+    }
+
+    size_t GetPositionBytes() const
+    {
+        return position_offsets_.get_allocator().GetAllocatedBytes();
+    }
+
+private:
+    static constexpr size_t NO_TERM = static_cast<size_t>(-1);
+
+    //    terms_  NO_TERM,      
+    size_t FindTerm(uint32_t term) const
+    {
+        const auto it = std::lower_bound(terms_.begin(), terms_.end(), term);
+        return it != terms_.end() && *it == term ? static_cast<size_t>(it - terms_.begin()) : NO_TERM;
+    }
+
+    //         
+    void BuildImpactOrder()
+    {
+        impact_order_.reserve(postings_.size());
+        for (size_t index = 0; index < terms_.size(); ++index)
+        {
+            const auto first = impact_order_.end() - impact_order_.begin();
+            const Posting* postings = postings_.data() + term_offsets_[index];
+            for (uint32_t i = 0; i < term_offsets_[index + 1] - term_offsets_[index]; ++i)
+            {
+                impact_order_.push_back(i);
+            }
+            std::stable_sort(impact_order_.begin() + first, impact_order_.end(), [postings](uint32_t lhs, uint32_t rhs)
+                {
+                    return postings[lhs].second > postings[rhs].second;
+                });
+        }
+    }
+
+    int first_ordinal_;
+    int end_ordinal_;
+    int level_ = 0;
+    bool impact_ordered_;
+    //     ,   : terms_    ,
+    //    terms_[i]  [term_offsets_[i], term_offsets_[i + 1])
+    std::vector<size_t, CountingAllocator<size_t>> term_offsets_;
+    std::vector<uint32_t, CountingAllocator<uint32_t>> terms_;
+    std::vector<Posting, CountingAllocator<Posting>> postings_;
+    //   ,    postings_
+    std::vector<uint32_t, CountingAllocator<uint32_t>> impact_order_;
+    //   i  terms_[k]   positions_  term_position_offsets_[k] + position_offsets_[i].
+    //    32-;    
+    std::vector<uint32_t, CountingAllocator<uint32_t>> position_offsets_;
+    std::vector<size_t, CountingAllocator<size_t>> term_position_offsets_;
+    std::vector<uint8_t, CountingAllocator<uint8_t>> positions_;
+};
+
+//          .
+//      ,    MERGE_FACTOR 
+//    .     :  
+//  ,       
+class SegmentStore
+{
+public:
+    using SegmentPtr = std::shared_ptr<const FrozenSegment>;
+
+    static const size_t MERGE_FACTOR = 4;
+
+    SegmentStore() = default;
+    SegmentStore(const SegmentStore&) = delete;
+    SegmentStore& operator=(const SegmentStore&) = delete;
+
+    ~SegmentStore()
+    {
+        {
+            std::lock_guard guard(mutex_);
+            stop_ = true;
+        }
+        merge_needed_.notify_one();
+        if (merge_thread_.joinable())
+        {
+            merge_thread_.join();
+        }
+    }
+
+    void Add(SegmentPtr segment)
+    {
+        {
+            std::lock_guard guard(mutex_);
+            segments_.push_back(std::move(segment));
+            if (!merge_thread_.joinable())
+            {
+                merge_thread_ = std::thread(&SegmentStore::MergeLoop, this);
+            }
+        }
+        merge_needed_.notify_one();
+    }
+
+    std::vector<SegmentPtr> GetSnapshot() const
+    {
+        std::lock_guard guard(mutex_);
+        return segments_;
+    }
+
+    // ,      ,   
+    void WaitForIdle() const
+    {
+        std::unique_lock lock(mutex_);
+        merge_done_.wait(lock, [this]
+            {
+                return stop_ || FindMerge() == NO_MERGE;
+            });
+    }
+
+    //   
+    size_t GetMergeCount() const
+    {
+        std::lock_guard guard(mutex_);
+        return merge_count_;
+    }
+
+private:
+    static const size_t NO_MERGE = static_cast<size_t>(-1);
+    static constexpr std::chrono::milliseconds MIN_MERGE_RETRY_DELAY{ 10 };
+    static constexpr std::chrono::milliseconds MAX_MERGE_RETRY_DELAY{ 1000 };
+
+    //     MERGE_FACTOR    
+    size_t FindMerge() const
+    {
+        size_t run_start = 0;
+        for (size_t i = 1; i <= segments_.size(); ++i)
+        {
+            if (i == segments_.size() || segments_[i]->GetLevel() != segments_[run_start]->GetLevel())
+            {
+                run_start = i;
+            }
+            else if (i - run_start + 1 == MERGE_FACTOR)
+            {
+                return run_start;
+            }
+        }
+        return NO_MERGE;
+    }
+
+    void MergeLoop()
+    {
+        std::chrono::milliseconds retry_delay = MIN_MERGE_RETRY_DELAY;
+        std::unique_lock lock(mutex_);
+        while (true)
+        {
+            merge_needed_.wait(lock, [this]
+                {
+                    return stop_ || FindMerge() != NO_MERGE;
+                });
+            if (stop_)
+            {
+                return;
+            }
+            const size_t first = FindMerge();
+            SegmentPtr merged;
+            try
+            {
+                const std::vector<SegmentPtr> inputs(segments_.begin() + first, segments_.begin() + first + MERGE_FACTOR);
+                lock.unlock();
+                merged = std::make_shared<const FrozenSegment>(inputs);
+            }
+            catch (const std::bad_alloc&)
+            {
+            }
+            if (!lock.owns_lock())
+            {
+                lock.lock();
+            }
+            if (!merged)
+            {
+                //      ,     .
+                //    ,     
+                merge_needed_.wait_for(lock, retry_delay, [this]
+                    {
+                        return stop_;
+                    });
+                retry_delay = std::min(retry_delay * 2, MAX_MERGE_RETRY_DELAY);
+                continue;
+            }
+            retry_delay = MIN_MERGE_RETRY_DELAY;
+            //     ,      
+            segments_.erase(segments_.begin() + first, segments_.begin() + first + MERGE_FACTOR);
+            segments_.insert(segments_.begin() + first, std::move(merged));
+            ++merge_count_;
+            merge_done_.notify_all();
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable merge_needed_;
+    mutable std::condition_variable merge_done_;
+    std::vector<SegmentPtr> segments_;
+    size_t merge_count_ = 0;
+    bool stop_ = false;
+    std::thread merge_thread_;
+};
+
+// ,    IDF  :      .
+//   ,   IDF   ,     
+struct IdfStatistics
+{
+    int document_count = 0;
+    std::map<std::string, size_t, std::less<>> document_freqs;
+
+    size_t GetDocumentFreq(std::string_view word) const
+    {
+        const auto it = document_freqs.find(word);
+        return it == document_freqs.end() ? 0 : it->second;
+    }
+
+    void Add(const IdfStatistics& other)
+    {
+        document_count += other.document_count;
+        for (const auto& [word, document_freq] : other.document_freqs)
+        {
+            document_freqs[word] += document_freq;
+        }
+    }
+};
+
+//   .    ,       
+class CancellationToken
+{
+public:
+    CancellationToken()
+        : cancelled_(std::make_shared<std::atomic<bool>>(false))
+    { }
+
+    void Cancel() const
+    {
+        cancelled_->store(true, std::memory_order_relaxed);
+    }
+
+    bool IsCancelled() const
+    {
+        return cancelled_->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+// ,     .        .
+//      ShardedSearchServer 
+struct QueryControl
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    std::optional<CancellationToken> cancellation;
+    size_t postings_budget = std::numeric_limits<size_t>::max();
+
+    //     ,    QueryControl
+    bool IsBounded() const
+    {
+        return deadline != std::chrono::steady_clock::time_point::max() || cancellation
+            || postings_budget != std::numeric_limits<size_t>::max();
+    }
+
+    bool ShouldStop() const
+    {
+        return (cancellation && cancellation->IsCancelled()) || std::chrono::steady_clock::now() >= deadline;
+    }
+};
+
+// exhaustive == false,       :   
+//          
+struct SearchResult
+{
+    std::vector<Document> documents;
+    bool exhaustive = true;
+};
+
+inline Expected<std::vector<Document>> TakeDocuments(Expected<SearchResult>&& result)
+{
+    if (!result)
+    {
+        return result.GetError();
+    }
+    return std::move(result.GetValue().documents);
+}
+
+// IMPACT_ORDERED         
+//    (4   ).    QueryControl  
+//      ,       
+enum class PostingLayout
+{
+    DOCUMENT_ORDERED,
+    IMPACT_ORDERED,
+};
+
+//   BasicSearchServer.      
+//    ,   -  ;   -  
+//       .  TF-IDF: tf =   /  
+class TfIdfRanker
+{
+public:
+    void AddDocument(size_t /*document_length*/)
+    { }
+
+    //  term_count ,     :     
+    double ComputePostingWeight(size_t term_count, size_t document_length) const
+    {
+        const double inverse_length = 1.0 / document_length;
+        double weight = 0.0;
+        for (size_t i = 0; i < term_count; ++i)
+        {
+            weight += inverse_length;
+        }
+        return weight;
+    }
+
+    double ComputeTermWeight(int document_count, size_t document_freq) const
+    {
+        return log(document_count * 1.0 / document_freq);
+    }
+};
+
+// Okapi BM25.          
+//   ,         
+class Bm25Ranker
+{
+public:
+    explicit Bm25Ranker(double k1 = 1.2, double b = 0.75)
+        : k1_(k1)
+        , b_(b)
+    {
+        if (k1 < 0.0 || b < 0.0 || b > 1.0)
+        {
+            throw std::invalid_argument("   BM25"s);
+        }
+    }
+
+    void AddDocument(size_t document_length)
+    {
+        total_length_ += document_length;
+        ++document_count_;
+    }
+
+    double ComputePostingWeight(size_t term_count, size_t document_length) const
+    {
+        const double average_length = static_cast<double>(total_length_) / document_count_;
+        const double length_norm = k1_ * (1.0 - b_ + b_ * document_length / average_length);
+        return term_count * (k1_ + 1.0) / (term_count + length_norm);
+    }
+
+    double ComputeTermWeight(int document_count, size_t document_freq) const
+    {
+        return log(1.0 + (document_count - document_freq + 0.5) / (document_freq + 0.5));
+    }
+
+private:
+    double k1_;
+    double b_;
+    size_t total_length_ = 0;
+    size_t document_count_ = 0;
+};
+
+//         :   
+//   ,   .   
+//          
+template <typename Ranker = TfIdfRanker>
+class BasicSearchServer {
+public:    
+
+    template <typename StringContainer>
+    explicit BasicSearchServer(const StringContainer& stop_words, PostingLayout posting_layout = PostingLayout::DOCUMENT_ORDERED,
+        Ranker ranker = Ranker(), TextEncoding encoding = TextEncoding::UTF8)
+        : stop_words_(MakeNormalizedWords(stop_words, encoding))
+        , posting_layout_(posting_layout)
+        , encoding_(encoding)
+        , ranker_(std::move(ranker))
+    {
+        
+        for (const std::string& word : MakeUniqueNonEmptyStrings(stop_words)) {
+            if (!IsValidWord(word)) {
+                throw std::invalid_argument("   "s);
+            }
+        }         
+        
+    }
+
+    explicit BasicSearchServer(const std::string& stop_words_text, PostingLayout posting_layout = PostingLayout::DOCUMENT_ORDERED,
+        Ranker ranker = Ranker(), TextEncoding encoding = TextEncoding::UTF8)
+        : BasicSearchServer(SplitIntoWords(stop_words_text), posting_layout, std::move(ranker), encoding)
+    { }
+
+    //       
+    BasicSearchServer(const BasicSearchServer&) = delete;
+    BasicSearchServer(BasicSearchServer&&) = default;
+
+    void AddDocument(int document_id, const std::string& document, DocumentStatus status,
+        const std::vector<int>& ratings) 
+    {
+        ThrowIfError(TryAddDocument(document_id, document, status, ratings));
+    }
+
+    Expected<void> TryAddDocument(int document_id, const std::string& document, DocumentStatus status,
+        const std::vector<int>& ratings) 
+    {
+        if (document_id < 0)  
+        {
+            return SearchError::NEGATIVE_DOCUMENT_ID;
+        }
+        const std::string normalized_document = NormalizeText(document, encoding_);
+        Expected<std::vector<DocumentWord>> split_words = SplitIntoWordsNoStop(normalized_document);
+        if (!split_words)
+        {
+            return split_words.GetError();
+        }
+        const std::vector<DocumentWord>& words = split_words.GetValue();
+
+        std::unique_lock guard(*index_mutex_);
+        if (document_ordinals_.count(document_id) > 0)
+        {
+            return SearchError::DUPLICATE_DOCUMENT_ID;
+        }
+
+        const int ordinal = static_cast<int>(document_ids_.size());
+        //  (, )    
+        std::vector<std::pair<uint32_t, uint32_t>> term_positions;
+        term_positions.reserve(words.size());
+        for (const auto& [word, position] : words)
+        {
+            const uint32_t term = terms_.Intern(word);
+            if (term == term_postings_.size())
+            {
+                term_postings_.emplace_back(postings_allocator_);
+                fuzzy_index_.Add(term, word);
+            }
+            term_positions.emplace_back(term, position);
+        }
+        ranker_.AddDocument(words.size());
+        AddMutablePostings(ordinal, term_positions, words.size());
+        document_ordinals_.emplace(document_id, ordinal);
+        document_ids_.push_back(document_id);
+        document_data_.push_back({ ComputeAverageRating(ratings), status });
+        status_bitmaps_[static_cast<size_t>(status)].Set(ordinal, true);
+        if (document_ids_.size() - mutable_first_ordinal_ >= MUTABLE_SEGMENT_DOCUMENT_COUNT)
+        {
+            FreezeMutableSegment();
+        }
+        return {};
+    }
+
+    template <typename DocumentPredicate>
+    std::vector<Document>FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const
+    {
+        return ThrowIfError(TryFindTopDocuments(raw_query, document_predicate));
+    }
+
+   std::vector<Document>FindTopDocuments(const std::string& raw_query, DocumentStatus status) const
+   {
+        return FindTopDocuments(raw_query, DocumentStatusIs{ status });
+    }
+
+    std::vector<Document> FindTopDocuments(const std::string& raw_query) const
+    {
+        return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+    }
+
+    template <typename DocumentPredicate>
+    Expected<std::vector<Document>> TryFindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const
+    {
+        return TakeDocuments(FindTopDocumentsWithOptions(raw_query, document_predicate, nullptr, nullptr));
+    }
+
+    //   IDF   ,     
+    template <typename DocumentPredicate>
+    Expected<std::vector<Document>> TryFindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate,
+        const IdfStatistics& idf_statistics) const
+    {
+        return TakeDocuments(FindTopDocumentsWithOptions(raw_query, document_predicate, &idf_statistics, nullptr));
+    }
+
+    // ,          
+    template <typename DocumentPredicate>
+    Expected<SearchResult> TryFindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate,
+        const QueryControl& control) const
+    {
+        return FindTopDocumentsWithOptions(raw_query, document_predicate, nullptr, &control);
+    }
+
+    template <typename DocumentPredicate>
+    Expected<SearchResult> TryFindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate,
+        const IdfStatistics& idf_statistics, const QueryControl& control) const
+    {
+        return FindTopDocumentsWithOptions(raw_query, document_predicate, &idf_statistics, &control);
+    }
+
+    Expected<std::vector<Document>> TryFindTopDocuments(const std::string& raw_query, DocumentStatus status) const
+    {
+        return TryFindTopDocuments(raw_query, DocumentStatusIs{ status });
+    }
+
+    Expected<std::vector<Document>> TryFindTopDocuments(const std::string& raw_query) const
+    {
+        return TryFindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+    }
+
+    //      -    
+    Expected<IdfStatistics> TryGetIdfStatistics(const std::string& raw_query) const
+    {
+        std::shared_lock guard(*index_mutex_);
+        Expected<Query> query = ParseQuery(raw_query);
+        if (!query)
+        {
+            return query.GetError();
+        }
+        const std::vector<SegmentStore::SegmentPtr> segments = segment_store_->GetSnapshot();
+        IdfStatistics statistics;
+        statistics.document_count = static_cast<int>(document_ids_.size());
+        for (const uint32_t term : query.GetValue().plus_terms)
+        {
+            statistics.document_freqs[std::string(terms_.GetTerm(term))] = GetDocumentFreq(segments, term);
+        }
+        return statistics;
+    }
+
+    int GetDocumentCount() const
+    {
+        std::shared_lock guard(*index_mutex_);
+        return document_ids_.size();
+    }
+
+    int GetDocumentId(int index) const
+    {
+        std::shared_lock guard(*index_mutex_);
+        if (index >= 0 && static_cast<size_t>(index) < document_ids_.size())
+        {
+            return document_ids_[index];
+        }
+        throw std::out_of_range("       "s);
+    }
+
+    void SetDocumentStatus(int document_id, DocumentStatus status)
+    {
+        std::unique_lock guard(*index_mutex_);
+        const auto it = document_ordinals_.find(document_id);
+        if (it == document_ordinals_.end())
+        {
+            throw std::out_of_range("    ID  "s);
+        }
+        const int ordinal = it->second;
+        DocumentData& document_data = document_data_[ordinal];
+        if (document_data.status == status)
+        {
+            return;
+        }
+        //  :    ,      
+        status_bitmaps_[static_cast<size_t>(status)].Set(ordinal, true);
+        status_bitmaps_[static_cast<size_t>(document_data.status)].Set(ordinal, false);
+        document_data.status = status;
+    }
+
+    // -,    ,     
+    //   max_edit_distance (1  2)   . 0    
+    void SetFuzzyMatching(int max_edit_distance)
+    {
+        if (max_edit_distance < 0 || max_edit_distance > MAX_FUZZY_EDIT_DISTANCE)
+        {
+            throw std::invalid_argument("       0  2"s);
+        }
+        std::unique_lock guard(*index_mutex_);
+        DeletionIndex fuzzy_index(max_edit_distance);
+        for (size_t term = 0; term < terms_.GetSize(); ++term)
+        {
+            fuzzy_index.Add(static_cast<uint32_t>(term), terms_.GetTerm(static_cast<uint32_t>(term)));
+        }
+        fuzzy_index_ = std::move(fuzzy_index);
+    }
+
+    //      ,    ,
+    //       
+    size_t WaitForMerges() const
+    {
+        segment_store_->WaitForIdle();
+        return segment_store_->GetMergeCount();
+    }
+
+    MemoryStats GetMemoryStats() const
+    {
+        std::shared_lock guard(*index_mutex_);
+        MemoryStats stats;
+        stats.stop_words = stop_words_.GetAllocatedBytes();
+        stats.dictionary = terms_.GetAllocatedBytes() + fuzzy_index_.GetAllocatedBytes();
+        stats.postings = postings_allocator_.GetAllocatedBytes() + term_postings_.get_allocator().GetAllocatedBytes();
+        for (const SegmentStore::SegmentPtr& segment : segment_store_->GetSnapshot())
+        {
+            stats.postings += segment->GetAllocatedBytes();
+        }
+        stats.positions = mutable_positions_.get_allocator().GetAllocatedBytes();
+        for (const SegmentStore::SegmentPtr& segment : segment_store_->GetSnapshot())
+        {
+            stats.positions += segment->GetPositionBytes();
+        }
+        stats.documents = document_ordinals_.get_allocator().GetAllocatedBytes()
+            + document_data_.get_allocator().GetAllocatedBytes();
+        for (const DocumentBitmap& bitmap : status_bitmaps_)
+        {
+            stats.documents += bitmap.GetAllocatedBytes();
+        }
+        stats.document_ids = document_ids_.get_allocator().GetAllocatedBytes();
+        return stats;
+    }
+
+#ifdef SEARCH_SERVER_TRACING
+    const QueryStatistics& GetQueryStatistics() const
+    {
+        return query_statistics_;
+    }
+
+    void SetSlowQueryThreshold(std::chrono::nanoseconds threshold)
+    {
+        query_statistics_.SetSlowQueryThreshold(threshold);
+    }
+
+    void ResetQueryStatistics()
+    {
+        query_statistics_.Reset();
+    }
+#endif
+
+    std::tuple<std::vector<std::string>, DocumentStatus>MatchDocument(const std::string& raw_query, int document_id) const
+    {
+         std::shared_lock guard(*index_mutex_);
+         const Query query = ThrowIfError(ParseQuery(raw_query));
+         const int ordinal = document_ordinals_.at(document_id);
+         const std::vector<SegmentStore::SegmentPtr> segments = segment_store_->GetSnapshot();
+         std::vector<std::string> matched_words;
+        for (const uint32_t term : query.plus_terms) 
+        {
+            if (ContainsPosting(segments, term, ordinal))
+            {
+                matched_words.emplace_back(terms_.GetTerm(term));
+            }
+        }
+        for (const uint32_t term : query.minus_terms) {
+            if (ContainsPosting(segments, term, ordinal)) 
+            {
+                matched_words.clear();
+                break;
+            }
+        }        
+        if (!MatchesPhrases(query, segments, ordinal))
+        {
+            matched_words.clear();
+        }
+        std::sort(matched_words.begin(), matched_words.end());
+        return { matched_words, document_data_[ordinal].status };
+    }
+
+private:
+    struct DocumentData 
+    {
+        int rating;
+        DocumentStatus status;
+    };
+    //     ,     
+    //      
+    static const size_t MUTABLE_SEGMENT_DOCUMENT_COUNT = 1024;
+    //         
+    static constexpr size_t CONTROL_CHECK_POSTINGS = 4096;
+    //   *         ,   
+    // MAX_PREFIX_EXPANSION
+    static constexpr size_t MAX_PREFIX_EXPANSION = 16;
+    //         ,   
+    // MAX_FUZZY_EXPANSION,        MAX_FUZZY_CANDIDATES .
+    //      FUZZY_EDIT_WEIGHT   
+    static const int MAX_FUZZY_EDIT_DISTANCE = 2;
+    static constexpr size_t MAX_FUZZY_EXPANSION = 2;
+    static constexpr size_t MAX_FUZZY_CANDIDATES = 256;
+    static constexpr double FUZZY_EDIT_WEIGHT = 0.5;
+
+    //          
+    using Postings = std::map<int, double, std::less<int>, CountingAllocator<std::pair<const int, double>>>;
+
+    const StopWordFilter stop_words_;
+    const PostingLayout posting_layout_;
+    const TextEncoding encoding_;
+    Ranker ranker_;
+    TermDictionary terms_;
+    //            
+    CountingAllocator<std::pair<const int, double>> postings_allocator_;
+    //        terms_
+    std::vector<Postings, CountingAllocator<Postings>> term_postings_;
+    // ,      
+    DeletionIndex fuzzy_index_;
+    //          
+    size_t mutable_first_ordinal_ = 0;
+
+    //          
+    struct DocumentPositions
+    {
+        explicit DocumentPositions(const CountingAllocator<uint8_t>& allocator)
+            : terms(allocator)
+            , offsets(allocator)
+            , bytes(allocator)
+        { }
+
+        std::vector<uint32_t, CountingAllocator<uint32_t>> terms;
+        //   terms[i]  [offsets[i], offsets[i + 1])  bytes
+        std::vector<uint32_t, CountingAllocator<uint32_t>> offsets;
+        std::vector<uint8_t, CountingAllocator<uint8_t>> bytes;
+    };
+    //  i       mutable_first_ordinal_ + i.
+    //       
+    std::vector<DocumentPositions, CountingAllocator<DocumentPositions>> mutable_positions_;
+    //  ,        
+    std::unique_ptr<SegmentStore> segment_store_ = std::make_unique<SegmentStore>();
+    //    ,   .  ,    
+    std::unique_ptr<std::shared_mutex> index_mutex_ = std::make_unique<std::shared_mutex>();
+    std::map<int, int, std::less<int>, CountingAllocator<std::pair<const int, int>>> document_ordinals_;
+    std::vector<int, CountingAllocator<int>> document_ids_;
+    std::vector<DocumentData, CountingAllocator<DocumentData>> document_data_;
+    std::array<DocumentBitmap, DOCUMENT_STATUS_COUNT> status_bitmaps_;
+#ifdef SEARCH_SERVER_TRACING
+    mutable QueryStatistics query_statistics_;
+#endif
+
+    bool IsStopWord(std::string_view word) const
+    {
+        return stop_words_.Contains(word);
+    }
+
+    static bool IsValidWord(const std::string& word)
+    {
+        return none_of(word.begin(), word.end(), [](char c) 
+            {
+            return c >= '\0' && c < ' ';
+            });
+    }
+
+    
+
+    template <typename Value>
+    static Value ThrowIfError(Expected<Value>&& result)
+    {
+        if (!result)
+        {
+            throw std::invalid_argument(GetErrorMessage(result.GetError()));
+        }
+        return std::move(result.GetValue());
+    }
+
+    static void ThrowIfError(Expected<void>&& result)
+    {
+        if (!result)
+        {
+            throw std::invalid_argument(GetErrorMessage(result.GetError()));
+        }
+    }
+
+    struct DocumentWord
+    {
+        std::string_view text;
+        //       -
+        uint32_t position;
+    };
+
+    // text  ,    
+    Expected<std::vector<DocumentWord>>SplitIntoWordsNoStop(const std::string& text) const 
+    {
+         std::vector<DocumentWord> words;
+        uint32_t position = 0;
+        for (const Token& token : Tokenize(text))
+        {
+            if (!token.is_valid)
+            {
+               return SearchError::INVALID_DOCUMENT_WORD;
+            }
+            if (!IsStopWord(token.text))
+            {
+                words.push_back({ token.text, position });
+            }
+            ++position;
+        }        
+        return words;
+    }
+
+    static int ComputeAverageRating(const std::vector<int>& ratings) 
+    {
+        if (ratings.empty())
+        {
+            return 0;
+        }
+        int rating_sum = 0;
+        for (const int rating : ratings) 
+        {
+            rating_sum += rating;
+        }
+        return rating_sum / static_cast<int>(ratings.size());
+    }
+
+    struct QueryWord
+    {        
+        std::string_view data;
+        bool is_minus;
+        bool is_stop;
+        //   *  , data    *
+        bool is_prefix;
+    };
+
+    
+
+    Expected<QueryWord> ParseQueryWord(const Token& token) const
+    {        
+        std::string_view text = token.text;
+        bool is_minus = false;
+        if (text[0] == '-') 
+        {
+            is_minus = true;
+            text.remove_prefix(1);
+        }
+        if (!text.empty() && text[0] == '-')
+        {
+            return SearchError::QUERY_DOUBLE_MINUS;
+        }
+        if (!token.is_valid) 
+        {
+            return SearchError::QUERY_INVALID_WORD;
+        }     
+        if (text.empty()) 
+        {
+            return SearchError::QUERY_SINGLE_MINUS;
+        }
+        if (text.back() == '*')
+        {
+            text.remove_suffix(1);
+            if (text.empty())
+            {
+                return SearchError::QUERY_EMPTY_PREFIX;
+            }
+            return QueryWord{ text, is_minus, false, true };
+        }
+        return QueryWord{ text, is_minus, IsStopWord(text), false };
+    }
+
+    struct PhraseTerm
+    {
+        // NO_TERM,     
+        uint32_t term;
+        //     ,   -
+        uint32_t offset;
+    };
+    using Phrase = std::vector<PhraseTerm>;
+
+    //  ,     . ,    , 
+    //    .        plus_terms, 
+    //   
+    struct Query
+    {        
+        std::vector<uint32_t> plus_terms;
+        std::vector<uint32_t> minus_terms;
+        //   -,     ,   
+        std::vector<std::pair<uint32_t, double>> fuzzy_weights;
+        std::vector<Phrase> plus_phrases;
+        std::vector<Phrase> minus_phrases;
+    };
+
+    //       "  -"     "  
+    static bool IsPhraseStart(std::string_view word)
+    {
+        return (!word.empty() && word[0] == '"') || (word.size() > 1 && word[0] == '-' && word[1] == '"');
+    }
+
+    static void AddPhrase(Phrase phrase, bool is_minus, Query& query)
+    {
+        if (phrase.empty())
+        {
+            return;
+        }
+        const uint32_t first_offset = phrase.front().offset;
+        for (PhraseTerm& phrase_term : phrase)
+        {
+            phrase_term.offset -= first_offset;
+        }
+        const bool has_unknown_term = std::any_of(phrase.begin(), phrase.end(), [](const PhraseTerm& phrase_term)
+            {
+                return phrase_term.term == TermDictionary::NO_TERM;
+            });
+        if (is_minus)
+        {
+            //          
+            if (!has_unknown_term)
+            {
+                query.minus_phrases.push_back(std::move(phrase));
+            }
+            return;
+        }
+        for (const PhraseTerm& phrase_term : phrase)
+        {
+            if (phrase_term.term != TermDictionary::NO_TERM)
+            {
+                query.plus_terms.push_back(phrase_term.term);
+            }
+        }
+        query.plus_phrases.push_back(std::move(phrase));
+    }
+
+    // ,    idf_statistics,      ,   
+    Expected<Query> ParseQuery(const std::string& text, const IdfStatistics* idf_statistics = nullptr) const
+    {        
+        Query query;
+        //         
+        std::optional<Phrase> phrase;
+        bool is_minus_phrase = false;
+        uint32_t phrase_position = 0;
+        const std::string normalized_text = NormalizeText(text, encoding_, true);
+        for (const Token& token : Tokenize(normalized_text))
+        {
+            std::string_view word = token.text;
+            if (!phrase && IsPhraseStart(word))
+            {
+                is_minus_phrase = word[0] == '-';
+                word.remove_prefix(is_minus_phrase ? 2 : 1);
+                phrase.emplace();
+                phrase_position = 0;
+            }
+            if (phrase)
+            {
+                const bool is_phrase_end = !word.empty() && word.back() == '"';
+                if (is_phrase_end)
+                {
+                    word.remove_suffix(1);
+                }
+                if (!word.empty())
+                {
+                    if (!token.is_valid)
+                    {
+                        return SearchError::QUERY_INVALID_WORD;
+                    }
+                    if (!IsStopWord(word))
+                    {
+                        phrase->push_back({ terms_.Find(word), phrase_position });
+                    }
+                    ++phrase_position;
+                }
+                if (is_phrase_end)
+                {
+                    AddPhrase(std::move(*phrase), is_minus_phrase, query);
+                    phrase.reset();
+                }
+                continue;
+            }
+            const Expected<QueryWord> parsed_word = ParseQueryWord(token);
+            if (!parsed_word)
+            {
+                return parsed_word.GetError();
+            }
+            const QueryWord& query_word = parsed_word.GetValue();
+            if (query_word.is_prefix)
+            {
+                ExpandPrefix(query_word.data, query_word.is_minus ? query.minus_terms : query.plus_terms);
+            }
+            else if (!query_word.is_stop)
+            {
+                const uint32_t term = terms_.Find(query_word.data);
+                if (term == TermDictionary::NO_TERM)
+                {
+                    if (!query_word.is_minus && !(idf_statistics && idf_statistics->GetDocumentFreq(query_word.data) > 0))
+                    {
+                        AddFuzzyTerms(query_word.data, query.fuzzy_weights);
+                    }
+                    continue;
+                }
+                if (query_word.is_minus)
+                {
+                    query.minus_terms.push_back(term);
+                }
+                else
+                {
+                    query.plus_terms.push_back(term);
+                }
+            }
+        }
+        if (phrase)
+        {
+            return SearchError::QUERY_UNTERMINATED_PHRASE;
+        }
+        for (std::vector<uint32_t>* terms : { &query.plus_terms, &query.minus_terms })
+        {
+            std::sort(terms->begin(), terms->end());
+            terms->erase(std::unique(terms->begin(), terms->end()), terms->end());
+        }
+        if (!query.fuzzy_weights.empty())
+        {
+            MergeFuzzyTerms(query);
+        }
+        return query;
+    }
+
+    //       
+    void AddFuzzyTerms(std::string_view word, std::vector<std::pair<uint32_t, double>>& fuzzy_weights) const
+    {
+        if (fuzzy_index_.GetMaxEditDistance() == 0)
+        {
+            return;
+        }
+        std::vector<uint32_t> candidates;
+        fuzzy_index_.FindCandidates(word, MAX_FUZZY_CANDIDATES, candidates);
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        const std::u32string symbols = DecodeSymbols(word);
+        int best_distance = fuzzy_index_.GetMaxEditDistance();
+        std::vector<uint32_t> nearest;
+        for (const uint32_t term : candidates)
+        {
+            const int distance = ComputeEditDistance(symbols, DecodeSymbols(terms_.GetTerm(term)), best_distance);
+            if (distance > best_distance)
+            {
+                continue;
+            }
+            if (distance < best_distance)
+            {
+                best_distance = distance;
+                nearest.clear();
+            }
+            nearest.push_back(term);
+        }
+        const size_t count = std::min(nearest.size(), MAX_FUZZY_EXPANSION);
+        std::partial_sort(nearest.begin(), nearest.begin() + count, nearest.end(),
+            [this](uint32_t lhs, uint32_t rhs)
+            {
+                return terms_.GetFrequency(lhs) > terms_.GetFrequency(rhs);
+            });
+        const double weight = std::pow(FUZZY_EDIT_WEIGHT, best_distance);
+        for (size_t i = 0; i < count; ++i)
+        {
+            fuzzy_weights.emplace_back(nearest[i], weight);
+        }
+    }
+
+    //  ,   ,  plus_terms. ,   ,
+    //   ,      -  
+    static void MergeFuzzyTerms(Query& query)
+    {
+        std::vector<std::pair<uint32_t, double>>& fuzzy_weights = query.fuzzy_weights;
+        std::sort(fuzzy_weights.begin(), fuzzy_weights.end(), [](const auto& lhs, const auto& rhs)
+            {
+                return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second > rhs.second);
+            });
+        fuzzy_weights.erase(std::unique(fuzzy_weights.begin(), fuzzy_weights.end(), [](const auto& lhs, const auto& rhs)
+            {
+                return lhs.first == rhs.first;
+            }), fuzzy_weights.end());
+        fuzzy_weights.erase(std::remove_if(fuzzy_weights.begin(), fuzzy_weights.end(), [&query](const auto& fuzzy_weight)
+            {
+                return std::binary_search(query.plus_terms.begin(), query.plus_terms.end(), fuzzy_weight.first);
+            }), fuzzy_weights.end());
+        for (const auto& [term, _] : fuzzy_weights)
+        {
+            query.plus_terms.push_back(term);
+        }
+        std::sort(query.plus_terms.begin(), query.plus_terms.end());
+    }
+
+    //     .  -    
+    //      .
+    //       
+    void ExpandPrefix(std::string_view prefix, std::vector<uint32_t>& terms) const
+    {
+        terms_.FindMostFrequent(prefix, MAX_PREFIX_EXPANSION, terms);
+    }
+
+    template <typename DocumentPredicate>
+    Expected<SearchResult> FindTopDocumentsWithOptions(const std::string& raw_query, DocumentPredicate document_predicate,
+        const IdfStatistics* idf_statistics, const QueryControl* control) const
+    {
+        SEARCH_TRACE(QueryTracer tracer(query_statistics_, raw_query);)
+        std::shared_lock guard(*index_mutex_);
+        Expected<Query> query = ParseQuery(raw_query, idf_statistics);
+        if (!query)
+        {
+            return query.GetError();
+        }
+        SEARCH_TRACE(QueryTracer::EnterStage(QueryStage::POSTINGS);)
+        SearchResult result = FindAllDocuments(query.GetValue(), document_predicate, idf_statistics, control);
+        std::vector<Document>& matched_documents = result.documents;
+        SEARCH_TRACE(QueryTracer::EnterStage(QueryStage::SORT);)
+        sort(matched_documents.begin(), matched_documents.end(), IsMoreRelevant);
+        SEARCH_TRACE(QueryTracer::EnterStage(QueryStage::TRUNCATE);)
+        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) 
+        {
+            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+        return result;
+    }
+
+    size_t GetDocumentFreq(const std::vector<SegmentStore::SegmentPtr>& segments, uint32_t term) const
+    {
+        size_t document_freq = term_postings_[term].size();
+        for (const SegmentStore::SegmentPtr& segment : segments)
+        {
+            document_freq += segment->GetPostings(term).size();
+        }
+        return document_freq;
+    }
+
+    //  idf_statistics IDF     
+    double ComputeTermInverseDocumentFreq(const std::vector<SegmentStore::SegmentPtr>& segments, uint32_t term,
+        const IdfStatistics* idf_statistics) const
+    {
+        if (idf_statistics)
+        {
+            return ranker_.ComputeTermWeight(idf_statistics->document_count, idf_statistics->GetDocumentFreq(terms_.GetTerm(term)));
+        }
+        return ranker_.ComputeTermWeight(static_cast<int>(document_ids_.size()), GetDocumentFreq(segments, term));
+    }
+
+    //  - : IDF    ,   
+    double ComputeQueryTermWeight(const Query& query, const std::vector<SegmentStore::SegmentPtr>& segments, uint32_t term,
+        const IdfStatistics* idf_statistics) const
+    {
+        const double inverse_document_freq = ComputeTermInverseDocumentFreq(segments, term, idf_statistics);
+        const auto it = std::lower_bound(query.fuzzy_weights.begin(), query.fuzzy_weights.end(), term,
+            [](const std::pair<uint32_t, double>& fuzzy_weight, uint32_t value)
+            {
+                return fuzzy_weight.first < value;
+            });
+        return it != query.fuzzy_weights.end() && it->first == term ? inverse_document_freq * it->second : inverse_document_freq;
+    }
+
+    void FreezeMutableSegment()
+    {
+        const int end_ordinal = static_cast<int>(document_ids_.size());
+        auto segment = std::make_shared<const FrozenSegment>(term_postings_,
+            [this](uint32_t term, int ordinal)
+            {
+                return GetMutablePositions(term, ordinal);
+            },
+            static_cast<int>(mutable_first_ordinal_), end_ordinal, posting_layout_ == PostingLayout::IMPACT_ORDERED);
+        segment_store_->Add(std::move(segment));
+        for (Postings& postings : term_postings_)
+        {
+            postings.clear();
+        }
+        mutable_positions_.clear();
+        mutable_first_ordinal_ = end_ordinal;
+    }
+
+    //           .
+    // term_positions   (, )    
+    void AddMutablePostings(int ordinal, std::vector<std::pair<uint32_t, uint32_t>>& term_positions, size_t document_length)
+    {
+        std::sort(term_positions.begin(), term_positions.end());
+        DocumentPositions& document = mutable_positions_.emplace_back(CountingAllocator<uint8_t>(mutable_positions_.get_allocator()));
+        std::vector<uint32_t> positions;
+        for (auto it = term_positions.begin(); it != term_positions.end();)
+        {
+            const uint32_t term = it->first;
+            positions.clear();
+            for (; it != term_positions.end() && it->first == term; ++it)
+            {
+                positions.push_back(it->second);
+            }
+            term_postings_[term].emplace(ordinal, ranker_.ComputePostingWeight(positions.size(), document_length));
+            terms_.IncrementFrequency(term);
+            document.terms.push_back(term);
+            document.offsets.push_back(static_cast<uint32_t>(document.bytes.size()));
+            EncodePositions(positions.data(), positions.data() + positions.size(), document.bytes);
+        }
+        document.offsets.push_back(static_cast<uint32_t>(document.bytes.size()));
+    }
+
+    EncodedPositions GetMutablePositions(uint32_t term, int ordinal) const
+    {
+        const DocumentPositions& document = mutable_positions_[ordinal - mutable_first_ordinal_];
+        const auto it = std::lower_bound(document.terms.begin(), document.terms.end(), term);
+        if (it == document.terms.end() || *it != term)
+        {
+            return {};
+        }
+        const size_t index = it - document.terms.begin();
+        return { document.bytes.data() + document.offsets[index], document.bytes.data() + document.offsets[index + 1] };
+    }
+
+    // ,    
+    static const FrozenSegment* FindSegment(const std::vector<SegmentStore::SegmentPtr>& segments, int ordinal)
+    {
+        const auto segment = std::upper_bound(segments.begin(), segments.end(), ordinal,
+            [](int value, const SegmentStore::SegmentPtr& segment)
+            {
+                return value < segment->GetEndOrdinal();
+            });
+        return segment != segments.end() ? segment->get() : nullptr;
+    }
+
+    bool ContainsPosting(const std::vector<SegmentStore::SegmentPtr>& segments, uint32_t term, int ordinal) const
+    {
+        if (static_cast<size_t>(ordinal) >= mutable_first_ordinal_)
+        {
+            return term_postings_[term].count(ordinal) > 0;
+        }
+        const FrozenSegment* segment = FindSegment(segments, ordinal);
+        return segment && segment->Contains(term, ordinal);
+    }
+
+    EncodedPositions GetPositions(const std::vector<SegmentStore::SegmentPtr>& segments, uint32_t term, int ordinal) const
+    {
+        if (term == TermDictionary::NO_TERM)
+        {
+            return {};
+        }
+        if (static_cast<size_t>(ordinal) >= mutable_first_ordinal_)
+        {
+            return GetMutablePositions(term, ordinal);
+        }
+        const FrozenSegment* segment = FindSegment(segments, ordinal);
+        return segment ? segment->GetPositions(term, ordinal) : EncodedPositions{};
+    }
+
+    //         :   
+    //         .
+    // positions - ,   
+    bool ContainsPhrase(const std::vector<SegmentStore::SegmentPtr>& segments, const Phrase& phrase, int ordinal,
+        std::vector<std::vector<uint32_t>>& positions) const
+    {
+        positions.resize(phrase.size());
+        for (size_t i = 0; i < phrase.size(); ++i)
+        {
+            DecodePositions(GetPositions(segments, phrase[i].term, ordinal), positions[i]);
+            if (positions[i].empty())
+            {
+                return false;
+            }
+        }
+        std::vector<size_t> cursors(phrase.size(), 0);
+        for (const uint32_t start : positions[0])
+        {
+            bool matched = true;
+            for (size_t i = 1; i < phrase.size() && matched; ++i)
+            {
+                const uint32_t target = start + phrase[i].offset;
+                size_t& cursor = cursors[i];
+                while (cursor < positions[i].size() && positions[i][cursor] < target)
+                {
+                    ++cursor;
+                }
+                if (cursor == positions[i].size())
+                {
+                    return false;
+                }
+                matched = positions[i][cursor] == target;
+            }
+            if (matched)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //           
+    bool MatchesPhrases(const Query& query, const std::vector<SegmentStore::SegmentPtr>& segments, int ordinal) const
+    {
+        std::vector<std::vector<uint32_t>> positions;
+        return MatchesPhrases(query, segments, ordinal, positions);
+    }
+
+    bool MatchesPhrases(const Query& query, const std::vector<SegmentStore::SegmentPtr>& segments, int ordinal,
+        std::vector<std::vector<uint32_t>>& positions) const
+    {
+        for (const Phrase& phrase : query.plus_phrases)
+        {
+            if (!ContainsPhrase(segments, phrase, ordinal, positions))
+            {
+                return false;
+            }
+        }
+        for (const Phrase& phrase : query.minus_phrases)
+        {
+            if (ContainsPhrase(segments, phrase, ordinal, positions))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //     . skip_to(first, ordinal)  
+    //   [first, last)     ordinal
+    template <typename PostingIterator, typename SkipTo, typename DocumentPredicate>
+    void AccumulateRelevance(PostingIterator first, PostingIterator last, SkipTo skip_to, double inverse_document_freq,
+        const DocumentPredicate& document_predicate, std::map<int, double>& document_to_relevance) const
+    {
+        if constexpr (std::is_same_v<DocumentPredicate, DocumentStatusIs>)
+        {
+            //      :   
+            //   ,     
+            const DocumentBitmap& bitmap = status_bitmaps_[static_cast<size_t>(document_predicate.status)];
+            while (first != last)
+            {
+                const auto [ordinal, term_freq] = *first;
+                const size_t next_ordinal = bitmap.NextSetBit(ordinal);
+                if (next_ordinal == DocumentBitmap::NPOS)
+                {
+                    break;
+                }
+                if (next_ordinal != static_cast<size_t>(ordinal))
+                {
+                    first = skip_to(first, static_cast<int>(next_ordinal));
+                    continue;
+                }
+                document_to_relevance[ordinal] += term_freq * inverse_document_freq;
+                ++first;
+            }
+        }
+        else
+        {
+            for (; first != last; ++first)
+            {
+                const auto [ordinal, term_freq] = *first;
+                if (MatchesPredicate(ordinal, document_predicate))
+                {
+                    document_to_relevance[ordinal] += term_freq * inverse_document_freq;
+                }
+            }
+        }
+    }
+
+    template <typename DocumentPredicate>
+    bool MatchesPredicate(int ordinal, const DocumentPredicate& document_predicate) const
+    {
+        if constexpr (std::is_same_v<DocumentPredicate, DocumentStatusIs>)
+        {
+            return status_bitmaps_[static_cast<size_t>(document_predicate.status)].Test(ordinal);
+        }
+        else if constexpr (std::is_same_v<DocumentPredicate, DocumentRatingAtLeast>)
+        {
+            return document_data_[ordinal].rating >= document_predicate.min_rating;
+        }
+        else
+        {
+            const DocumentData& document_data = document_data_[ordinal];
+            return document_predicate(document_ids_[ordinal], document_data.status, document_data.rating);
+        }
+    }
+
+    //   -    term_freq * IDF:      ,
+    //   ,  .    
+    //   .  false,    ,   
+    template <typename DocumentPredicate>
+    bool AccumulateRelevanceByImpact(const Query& query, const std::vector<SegmentStore::SegmentPtr>& segments,
+        const DocumentPredicate& document_predicate, const IdfStatistics* idf_statistics, const QueryControl& control,
+        std::map<int, double>& document_to_relevance) const
+    {
+        struct Cursor
+        {
+            const FrozenSegment::Posting* postings;
+            // nullptr,  postings    
+            const uint32_t* order;
+            size_t position;
+            size_t size;
+            double inverse_document_freq;
+
+            const FrozenSegment::Posting& GetPosting() const
+            {
+                return postings[order ? order[position] : position];
+            }
+
+            double GetImpact() const
+            {
+                return GetPosting().second * inverse_document_freq;
+            }
+        };
+
+        std::vector<Cursor> cursors;
+        std::vector<std::vector<FrozenSegment::Posting>> mutable_postings;
+        mutable_postings.reserve(query.plus_terms.size());
+        for (const uint32_t term : query.plus_terms)
+        {
+            const double inverse_document_freq = ComputeQueryTermWeight(query, segments, term, idf_statistics);
+            for (const SegmentStore::SegmentPtr& segment : segments)
+            {
+                const FrozenSegment::PostingRange range = segment->GetPostings(term);
+                if (range.size() > 0)
+                {
+                    cursors.push_back({ range.begin(), segment->GetImpactOrder(term), 0, range.size(), inverse_document_freq });
+                }
+            }
+            const Postings& postings = term_postings_[term];
+            if (!postings.empty())
+            {
+                std::vector<FrozenSegment::Posting>& sorted = mutable_postings.emplace_back(postings.begin(), postings.end());
+                std::stable_sort(sorted.begin(), sorted.end(), [](const FrozenSegment::Posting& lhs, const FrozenSegment::Posting& rhs)
+                    {
+                        return lhs.second > rhs.second;
+                    });
+                cursors.push_back({ sorted.data(), nullptr, 0, sorted.size(), inverse_document_freq });
+            }
+        }
+
+        //      
+        std::priority_queue<std::pair<double, size_t>> heads;
+        for (size_t i = 0; i < cursors.size(); ++i)
+        {
+            heads.push({ cursors[i].GetImpact(), i });
+        }
+        bool exhaustive = true;
+        size_t processed_count = 0;
+        while (!heads.empty())
+        {
+            if (processed_count == control.postings_budget
+                || (processed_count % CONTROL_CHECK_POSTINGS == 0 && control.ShouldStop()))
+            {
+                exhaustive = false;
+                break;
+            }
+            const size_t index = heads.top().second;
+            heads.pop();
+            Cursor& cursor = cursors[index];
+            const auto [ordinal, term_freq] = cursor.GetPosting();
+            if (MatchesPredicate(ordinal, document_predicate))
+            {
+                document_to_relevance[ordinal] += term_freq * cursor.inverse_document_freq;
+            }
+            ++processed_count;
+            if (++cursor.position < cursor.size)
+            {
+                heads.push({ cursor.GetImpact(), index });
+            }
+        }
+        SEARCH_TRACE(QueryTracer::CountPostings(processed_count);)
+        return exhaustive;
+    }
+
+    // ,     control      CONTROL_CHECK_POSTINGS
+    // ; -     
+    template <typename DocumentPredicate>
+    SearchResult FindAllDocuments(const Query& query, DocumentPredicate document_predicate,
+        const IdfStatistics* idf_statistics, const QueryControl* control) const 
+    {
+        const std::vector<SegmentStore::SegmentPtr> segments = segment_store_->GetSnapshot();
+        std::map<int, double> document_to_relevance;
+        bool exhaustive = true;
+        if (control && !control->IsBounded())
+        {
+            control = nullptr;
+        }
+        if (control && posting_layout_ == PostingLayout::IMPACT_ORDERED)
+        {
+            exhaustive = AccumulateRelevanceByImpact(query, segments, document_predicate, idf_statistics, *control,
+                document_to_relevance);
+        }
+        else
+        {
+            size_t postings_left = control ? control->postings_budget : std::numeric_limits<size_t>::max();
+            const auto should_stop = [control, &exhaustive, &postings_left]
+            {
+                if (exhaustive && control && (postings_left == 0 || control->ShouldStop()))
+                {
+                    exhaustive = false;
+                }
+                return !exhaustive;
+            };
+            for (const uint32_t term : query.plus_terms)
+            {
+                const Postings& postings = term_postings_[term];
+                const double inverse_document_freq = ComputeQueryTermWeight(query, segments, term, idf_statistics);
+                SEARCH_TRACE(QueryTracer::CountPostings(GetDocumentFreq(segments, term));)
+                for (const SegmentStore::SegmentPtr& segment : segments)
+                {
+                    const FrozenSegment::PostingRange range = segment->GetPostings(term);
+                    for (const FrozenSegment::Posting* block_begin = range.begin(); block_begin != range.end() && !should_stop();)
+                    {
+                        const size_t block_size = std::min<size_t>({ CONTROL_CHECK_POSTINGS, postings_left,
+                            static_cast<size_t>(range.end() - block_begin) });
+                        const FrozenSegment::Posting* block_end = block_begin + block_size;
+                        AccumulateRelevance(block_begin, block_end,
+                            [block_end](const FrozenSegment::Posting* posting, int ordinal)
+                            {
+                                return std::lower_bound(posting, block_end, FrozenSegment::Posting{ ordinal, 0.0 }, FrozenSegment::ComparePostings);
+                            },
+                            inverse_document_freq, document_predicate, document_to_relevance);
+                        block_begin = block_end;
+                        postings_left -= block_size;
+                    }
+                }
+                if (postings.empty())
+                {
+                    continue;
+                }
+                if (should_stop())
+                {
+                    break;
+                }
+                //       
+                const auto last = postings.size() <= postings_left ? postings.end() : std::next(postings.begin(), postings_left);
+                const int last_ordinal = last == postings.end() ? std::numeric_limits<int>::max() : last->first;
+                AccumulateRelevance(postings.begin(), last,
+                    [&postings, last, last_ordinal](Postings::const_iterator, int ordinal)
+                    {
+                        return ordinal >= last_ordinal ? last : postings.lower_bound(ordinal);
+                    },
+                    inverse_document_freq, document_predicate, document_to_relevance);
+                if (last != postings.end())
+                {
+                    exhaustive = false;
+                    break;
+                }
+                postings_left -= postings.size();
+            }
+        }
+        SEARCH_TRACE(QueryTracer::CountCandidates(document_to_relevance.size());)
+
+        SEARCH_TRACE(QueryTracer::EnterStage(QueryStage::MINUS_WORDS);)
+        for (const uint32_t term : query.minus_terms) 
+        {
+            SEARCH_TRACE(QueryTracer::CountPostings(term_postings_[term].size());)
+            for (const auto& [ordinal, _] : term_postings_[term])
+            {
+                document_to_relevance.erase(ordinal);
+            }
+            for (const SegmentStore::SegmentPtr& segment : segments)
+            {
+                SEARCH_TRACE(QueryTracer::CountPostings(segment->GetPostings(term).size());)
+                for (const auto& [ordinal, _] : segment->GetPostings(term))
+                {
+                    document_to_relevance.erase(ordinal);
+                }
+            }
+        }
+
+        SEARCH_TRACE(QueryTracer::EnterStage(QueryStage::PHRASES);)
+        if (!query.plus_phrases.empty() || !query.minus_phrases.empty())
+        {
+            std::vector<std::vector<uint32_t>> positions;
+            for (auto it = document_to_relevance.begin(); it != document_to_relevance.end();)
+            {
+                it = MatchesPhrases(query, segments, it->first, positions) ? std::next(it) : document_to_relevance.erase(it);
+            }
+        }
+
+        SEARCH_TRACE(QueryTracer::EnterStage(QueryStage::COLLECT);)
+        std::vector<Document> matched_documents;
+        for (const auto& [ordinal, relevance] : document_to_relevance)
+        {
+            matched_documents.push_back({ document_ids_[ordinal], relevance, document_data_[ordinal].rating });
+        }
+        return { std::move(matched_documents), exhaustive };
+    }
+};
+
+using SearchServer = BasicSearchServer<>;
+
+
+
+
+
+//  ,       .       ,
+//     -   . ,       Await,
+//     ,        
+class WorkStealingExecutor
+{
+public:
+    explicit WorkStealingExecutor(size_t thread_count)
+    {
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            threads_.emplace_back([this, i]
+                {
+                    Run(i);
+                });
+        }
+    }
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    //  ,     
+    ~WorkStealingExecutor()
+    {
+        {
+            std::lock_guard guard(mutex_);
+            stop_ = true;
+        }
+        task_added_.notify_all();
+        for (std::thread& thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    //         ,    .
+    //     future
+    template <typename Function>
+    auto Submit(Function function) -> std::future<decltype(function())>
+    {
+        auto task = std::make_shared<std::packaged_task<decltype(function())()>>(std::move(function));
+        auto result = task->get_future();
+        const size_t index = current_executor_ == this
+            ? current_worker_
+            : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+        {
+            Worker& worker = *workers_[index];
+            std::lock_guard guard(worker.mutex);
+            worker.tasks.push_back([task]
+                {
+                    (*task)();
+                });
+            //     ,     ,   
+            pending_.fetch_add(1);
+        }
+        WakeIdleWorker();
+        WakeAwaitingThreads();
+        return result;
+    }
+
+    //   ,    ,    ,    ,
+    //    -    
+    template <typename Value>
+    Value Await(std::future<Value>& result)
+    {
+        if (current_executor_ == this)
+        {
+            while (true)
+            {
+                //     :     ,  
+                const size_t finished = finished_tasks_.load();
+                if (IsReady(result))
+                {
+                    break;
+                }
+                if (RunOneTask(current_worker_))
+                {
+                    continue;
+                }
+                std::unique_lock lock(mutex_);
+                awaiting_threads_.fetch_add(1);
+                task_finished_.wait(lock, [this, finished]
+                    {
+                        return pending_.load() > 0 || finished_tasks_.load() != finished;
+                    });
+                awaiting_threads_.fetch_sub(1);
+            }
+        }
+        return result.get();
+    }
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    template <typename Value>
+    static bool IsReady(const std::future<Value>& result)
+    {
+        return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    // ,   ,     sleepers.      ,
+    //     ,        .
+    //   mutex_ ,  ,   ,     
+    bool SyncWithSleepers(const std::atomic<size_t>& sleepers)
+    {
+        if (sleepers.load() == 0)
+        {
+            return false;
+        }
+        std::lock_guard guard(mutex_);
+        return true;
+    }
+
+    //      
+    void WakeIdleWorker()
+    {
+        if (SyncWithSleepers(idle_workers_))
+        {
+            task_added_.notify_one();
+        }
+    }
+
+    //     ,   
+    void WakeAwaitingThreads()
+    {
+        if (SyncWithSleepers(awaiting_threads_))
+        {
+            task_finished_.notify_all();
+        }
+    }
+
+    bool TryTakeTask(size_t index, std::function<void()>& task)
+    {
+        for (size_t i = 0; i < workers_.size(); ++i)
+        {
+            Worker& worker = *workers_[(index + i) % workers_.size()];
+            std::lock_guard guard(worker.mutex);
+            if (worker.tasks.empty())
+            {
+                continue;
+            }
+            if (i == 0)
+            {
+                task = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    bool RunOneTask(size_t index)
+    {
+        std::function<void()> task;
+        if (!TryTakeTask(index, task))
+        {
+            return false;
+        }
+        pending_.fetch_sub(1);
+        task();
+        finished_tasks_.fetch_add(1);
+        WakeAwaitingThreads();
+        return true;
+    }
+
+    void Run(size_t index)
+    {
+        current_executor_ = this;
+        current_worker_ = index;
+        while (true)
+        {
+            if (RunOneTask(index))
+            {
+                continue;
+            }
+            std::unique_lock lock(mutex_);
+            idle_workers_.fetch_add(1);
+            task_added_.wait(lock, [this]
+                {
+                    return stop_ || pending_.load() > 0;
+                });
+            idle_workers_.fetch_sub(1);
+            if (stop_ && pending_.load() == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    static thread_local const WorkStealingExecutor* current_executor_;
+    static thread_local size_t current_worker_;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_worker_ = 0;
+    //  stop_     .       
+    std::mutex mutex_;
+    std::condition_variable task_added_;
+    std::condition_variable task_finished_;
+    //     
+    std::atomic<size_t> pending_ = 0;
+    //   . ,     
+    std::atomic<size_t> finished_tasks_ = 0;
+    //  ,   Run   Await
+    std::atomic<size_t> idle_workers_ = 0;
+    std::atomic<size_t> awaiting_threads_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+thread_local const WorkStealingExecutor* WorkStealingExecutor::current_executor_ = nullptr;
+thread_local size_t WorkStealingExecutor::current_worker_ = 0;
+
+//     .         ID.
+//         :     
+//  IDF,       ,    
+// .   TfIdfRanker      . Bm25Ranker
+//        ,    BM25 
+//   ,    .
+//       ,    
+template <typename Ranker = TfIdfRanker>
+class BasicShardedSearchServer
+{
+public:
+    template <typename StringContainer>
+    BasicShardedSearchServer(const StringContainer& stop_words, size_t shard_count,
+        PostingLayout posting_layout = PostingLayout::DOCUMENT_ORDERED, const Ranker& ranker = Ranker(),
+        TextEncoding encoding = TextEncoding::UTF8)
+    {
+        if (shard_count == 0)
+        {
+            throw std::invalid_argument("     "s);
+        }
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i)
+        {
+            shards_.push_back(std::make_unique<Shard>(stop_words, posting_layout, ranker, encoding));
+        }
+        executor_ = std::make_unique<WorkStealingExecutor>(shard_count);
+    }
+
+    BasicShardedSearchServer(const std::string& stop_words_text, size_t shard_count,
+        PostingLayout posting_layout = PostingLayout::DOCUMENT_ORDERED, const Ranker& ranker = Ranker(),
+        TextEncoding encoding = TextEncoding::UTF8)
+        : BasicShardedSearchServer(SplitIntoWords(stop_words_text), shard_count, posting_layout, ranker, encoding)
+    { }
+
+    void AddDocument(int document_id, const std::string& document, DocumentStatus status,
+        const std::vector<int>& ratings)
+    {
+        const Expected<void> result = TryAddDocument(document_id, document, status, ratings);
+        if (!result)
+        {
+            throw std::invalid_argument(GetErrorMessage(result.GetError()));
+        }
+    }
+
+    Expected<void> TryAddDocument(int document_id, const std::string& document, DocumentStatus status,
+        const std::vector<int>& ratings)
+    {
+        if (document_id < 0)
+        {
+            return SearchError::NEGATIVE_DOCUMENT_ID;
+        }
+        Shard& shard = GetShard(document_id);
+        {
+            std::lock_guard guard(shard.mutex);
+            const Expected<void> result = shard.server.TryAddDocument(document_id, document, status, ratings);
+            if (!result)
+            {
+                return result;
+            }
+        }
+        std::lock_guard guard(document_ids_mutex_);
+        document_ids_.push_back(document_id);
+        return {};
+    }
+
+    //   ,        
+    void SetFuzzyMatching(int max_edit_distance)
+    {
+        for (const auto& shard : shards_)
+        {
+            std::lock_guard guard(shard->mutex);
+            shard->server.SetFuzzyMatching(max_edit_distance);
+        }
+    }
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const
+    {
+        Expected<std::vector<Document>> result = TryFindTopDocuments(raw_query, document_predicate);
+        if (!result)
+        {
+            throw std::invalid_argument(GetErrorMessage(result.GetError()));
+        }
+        return std::move(result.GetValue());
+    }
+
+    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentStatus status) const
+    {
+        return FindTopDocuments(raw_query, DocumentStatusIs{ status });
+    }
+
+    std::vector<Document> FindTopDocuments(const std::string& raw_query) const
+    {
+        return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+    }
+
+    template <typename DocumentPredicate>
+    Expected<std::vector<Document>> TryFindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const
+    {
+        return TakeDocuments(TryFindTopDocuments(raw_query, document_predicate, QueryControl{}));
+    }
+
+    Expected<std::vector<Document>> TryFindTopDocuments(const std::string& raw_query, DocumentStatus status) const
+    {
+        return TryFindTopDocuments(raw_query, DocumentStatusIs{ status });
+    }
+
+    Expected<std::vector<Document>> TryFindTopDocuments(const std::string& raw_query) const
+    {
+        return TryFindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+    }
+
+    //       ,       
+    template <typename DocumentPredicate>
+    Expected<SearchResult> TryFindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate,
+        const QueryControl& control) const
+    {
+        //     :    ,
+        //           
+        const auto shared_query = std::make_shared<const std::string>(raw_query);
+        std::vector<std::future<Expected<IdfStatistics>>> shard_statistics;
+        for (const auto& shard : shards_)
+        {
+            shard_statistics.push_back(executor_->Submit([&shard = *shard, shared_query]
+                {
+                    std::shared_lock guard(shard.mutex);
+                    return shard.server.TryGetIdfStatistics(*shared_query);
+                }));
+        }
+        IdfStatistics idf_statistics;
+        //        ,    
+        std::optional<SearchError> error;
+        for (auto& statistics : shard_statistics)
+        {
+            Expected<IdfStatistics> result = executor_->Await(statistics);
+            if (!result)
+            {
+                error = result.GetError();
+                continue;
+            }
+            idf_statistics.Add(result.GetValue());
+        }
+        if (error)
+        {
+            return *error;
+        }
+
+        const auto shared_statistics = std::make_shared<const IdfStatistics>(std::move(idf_statistics));
+        std::vector<std::future<Expected<SearchResult>>> shard_results;
+        for (const auto& shard : shards_)
+        {
+            shard_results.push_back(executor_->Submit(
+                [&shard = *shard, shared_query, document_predicate, shared_statistics, control]
+                {
+                    std::shared_lock guard(shard.mutex);
+                    return shard.server.TryFindTopDocuments(*shared_query, document_predicate, *shared_statistics, control);
+                }));
+        }
+        SearchResult merged;
+        for (auto& shard_result : shard_results)
+        {
+            Expected<SearchResult> result = executor_->Await(shard_result);
+            if (!result)
+            {
+                error = result.GetError();
+                continue;
+            }
+            std::vector<Document>& documents = result.GetValue().documents;
+            merged.documents.insert(merged.documents.end(), documents.begin(), documents.end());
+            merged.exhaustive = merged.exhaustive && result.GetValue().exhaustive;
+        }
+        if (error)
+        {
+            return *error;
+        }
+        std::sort(merged.documents.begin(), merged.documents.end(), IsMoreRelevant);
+        if (merged.documents.size() > MAX_RESULT_DOCUMENT_COUNT)
+        {
+            merged.documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+        return merged;
+    }
+
+    //      ,    .
+    //     future
+    template <typename DocumentPredicate>
+    std::future<Expected<SearchResult>> FindTopDocumentsAsync(std::string raw_query, DocumentPredicate document_predicate,
+        QueryControl control) const
+    {
+        return executor_->Submit([this, raw_query = std::move(raw_query), document_predicate, control = std::move(control)]
+            {
+                return TryFindTopDocuments(raw_query, document_predicate, control);
+            });
+    }
+
+    std::future<Expected<SearchResult>> FindTopDocumentsAsync(std::string raw_query, DocumentStatus status,
+        QueryControl control) const
+    {
+        return FindTopDocumentsAsync(std::move(raw_query), DocumentStatusIs{ status }, std::move(control));
+    }
+
+    std::future<Expected<SearchResult>> FindTopDocumentsAsync(std::string raw_query, QueryControl control = {}) const
+    {
+        return FindTopDocumentsAsync(std::move(raw_query), DocumentStatus::ACTUAL, std::move(control));
+    }
+
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const
+    {
+        if (document_id < 0)
+        {
+            throw std::out_of_range("    ID  "s);
+        }
+        const Shard& shard = GetShard(document_id);
+        std::shared_lock guard(shard.mutex);
+        return shard.server.MatchDocument(raw_query, document_id);
+    }
+
+    int GetDocumentCount() const
+    {
+        std::lock_guard guard(document_ids_mutex_);
+        return static_cast<int>(document_ids_.size());
+    }
+
+    int GetDocumentId(int index) const
+    {
+        std::lock_guard guard(document_ids_mutex_);
+        if (index >= 0 && index < static_cast<int>(document_ids_.size()))
+        {
+            return document_ids_[index];
+        }
+        throw std::out_of_range("       "s);
+    }
+
+    size_t GetShardCount() const
+    {
+        return shards_.size();
+    }
+
+private:
+    struct Shard
+    {
+        template <typename StringContainer>
+        Shard(const StringContainer& stop_words, PostingLayout posting_layout, const Ranker& ranker, TextEncoding encoding)
+            : server(stop_words, posting_layout, ranker, encoding)
+        { }
+
+        BasicSearchServer<Ranker> server;
+        mutable std::shared_mutex mutex;
+    };
+
+    Shard& GetShard(int document_id) const
+    {
+        return *shards_[static_cast<size_t>(document_id) % shards_.size()];
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    // ID     GetDocumentId
+    mutable std::mutex document_ids_mutex_;
+    std::vector<int> document_ids_;
+    // :      ,    
+    std::unique_ptr<WorkStealingExecutor> executor_;
+};
+
+using ShardedSearchServer = BasicShardedSearchServer<>;
+
+void PrintDocument(const Document& document)
+{
+    std::cout << "{ "s
+        << "document_id = "s << document.id << ", "s
+        << "relevance = "s << document.relevance << ", "s
+        << "rating = "s << document.rating << " }"s << std::endl;
+}
+
+void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status)
+{
+    std::cout << "{ "s
+        << "document_id = "s << document_id << ", "s
+        << "status = "s << static_cast<int>(status) << ", "s
+        << "words ="s;
+    for (const std::string& word : words)
+    {
+        std::cout << ' ' << word;
+    }
+    std::cout << "}"s << std::endl;
+}
+
+void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status,
+    const std::vector<int>& ratings)
+{
+    try 
+    {
+        search_server.AddDocument(document_id, document, status, ratings);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "   "s << document_id << ": "s << e.what() << std::endl;
+    }
+}
+
+void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query) 
+{
+    std::cout << "   : "s << raw_query << std::endl;
+    try
+    {
+        for (const Document& document : search_server.FindTopDocuments(raw_query))
+        {
+            PrintDocument(document);
+        }
+    }
+    catch (const std::exception& e) 
+    {
+        std::cerr << " : "s << e.what() << std::endl;
+    }
+}
+
+void MatchDocuments(const SearchServer& search_server, const std::string& query)
+{
+    try
+    {
+        std::cout << "   : "s << query << std::endl;
+        const int document_count = search_server.GetDocumentCount();
+        for (int index = 0; index < document_count; ++index)
+        {
+            const int document_id = search_server.GetDocumentId(index);
+            const auto [words, status] = search_server.MatchDocument(query, document_id);
+            PrintMatchDocumentResult(document_id, words, status);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "     "s << query << ": "s << e.what() << std::endl;
+    }
+}
+
+#ifdef SEARCH_SERVER_TESTS
+//    .    -DSEARCH_SERVER_TESTS     main
+
+template <typename T>
+std::ostream& operator<<(std::ostream& os, const std::vector<T>& values)
+{
+    os << "["s;
+    bool first = true;
+    for (const T& value : values)
+    {
+        if (!first)
+        {
+            os << ", "s;
+        }
+        first = false;
+        os << value;
+    }
+    return os << "]"s;
+}
+
+std::ostream& operator<<(std::ostream& os, SearchError error)
+{
+    return os << static_cast<int>(error) << " ("s << GetErrorMessage(error) << ")"s;
+}
+
+template <typename T, typename U>
+void AssertEqual(const T& t, const U& u, const std::string& hint)
+{
+    if (t != u)
+    {
+        std::cerr << std::boolalpha;
+        std::cerr << "ASSERT_EQUAL failed: "s << t << " != "s << u << "."s;
+        if (!hint.empty())
+        {
+            std::cerr << " Hint: "s << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+void Assert(bool value, const std::string& hint)
+{
+    if (!value)
+    {
+        std::cerr << "Assertion failed. "s;
+        if (!hint.empty())
+        {
+            std::cerr << "Hint: "s << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+std::vector<int> GetDocumentIds(const std::vector<Document>& documents)
+{
+    std::vector<int> ids;
+    for (const Document& document : documents)
+    {
+        ids.push_back(document.id);
+    }
+    return ids;
+}
+
+void TestSetDocumentStatus()
+{
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, { 1 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 2 });
+    server.AddDocument(3, "groomed dog"s, DocumentStatus::BANNED, { 3 });
+
+    server.SetDocumentStatus(2, DocumentStatus::REMOVED);
+    AssertEqual(GetDocumentIds(server.FindTopDocuments("cat"s)).size(), 1u, "removed document is not ACTUAL"s);
+    AssertEqual(server.FindTopDocuments("cat"s)[0].id, 1, "only document 1 stays ACTUAL"s);
+    AssertEqual(server.FindTopDocuments("cat"s, DocumentStatus::REMOVED)[0].id, 2, "document 2 is found as REMOVED"s);
+    Assert(std::get<1>(server.MatchDocument("cat"s, 2)) == DocumentStatus::REMOVED, "MatchDocument reports the new status"s);
+
+    server.SetDocumentStatus(3, DocumentStatus::ACTUAL);
+    server.SetDocumentStatus(3, DocumentStatus::ACTUAL);
+    AssertEqual(server.FindTopDocuments("dog"s)[0].id, 3, "banned document becomes ACTUAL"s);
+    Assert(server.FindTopDocuments("dog"s, DocumentStatus::BANNED).empty(), "document leaves the old status"s);
+
+    const auto predicate_documents = server.FindTopDocuments("cat dog"s, [](int, DocumentStatus status, int) {
+        return status != DocumentStatus::ACTUAL;
+        });
+    AssertEqual(predicate_documents.size(), 1u, "predicate sees the new status"s);
+    AssertEqual(predicate_documents[0].id, 2, "predicate sees the new status"s);
+
+    try
+    {
+        server.SetDocumentStatus(42, DocumentStatus::BANNED);
+        Assert(false, "unknown document id must throw"s);
+    }
+    catch (const std::out_of_range&)
+    {
+    }
+}
+
+void TestSetDocumentStatusInFrozenSegment()
+{
+    SearchServer server(""s);
+    const int document_count = 3000;
+    for (int id = 0; id < document_count; ++id)
+    {
+        server.AddDocument(id, "common word"s + std::to_string(id % 7), DocumentStatus::ACTUAL, { id });
+    }
+    for (int id = 0; id < document_count; id += 3)
+    {
+        server.SetDocumentStatus(id, DocumentStatus::IRRELEVANT);
+    }
+    const auto is_irrelevant = [](int, DocumentStatus status, int) {
+        return status == DocumentStatus::IRRELEVANT;
+    };
+    for (const Document& document : server.FindTopDocuments("common"s, DocumentStatus::IRRELEVANT))
+    {
+        AssertEqual(document.id % 3, 0, "only every third document is IRRELEVANT"s);
+    }
+    AssertEqual(GetDocumentIds(server.FindTopDocuments("common"s, DocumentStatus::IRRELEVANT)),
+        GetDocumentIds(server.FindTopDocuments("common"s, is_irrelevant)), "bitmap filter matches the predicate"s);
+    for (const Document& document : server.FindTopDocuments("common"s))
+    {
+        Assert(document.id % 3 != 0, "IRRELEVANT documents are not ACTUAL"s);
+    }
+}
+
+void TestTryAddDocumentErrors()
+{
+    SearchServer server("and"s);
+    Assert(server.TryAddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 }).HasValue(), "valid document is added"s);
+
+    const Expected<void> negative_id = server.TryAddDocument(-1, "black cat"s, DocumentStatus::ACTUAL, { 1 });
+    Assert(!negative_id, "negative id is rejected"s);
+    AssertEqual(negative_id.GetError(), SearchError::NEGATIVE_DOCUMENT_ID, "negative id"s);
+
+    const Expected<void> duplicate_id = server.TryAddDocument(1, "black cat"s, DocumentStatus::ACTUAL, { 1 });
+    AssertEqual(duplicate_id.GetError(), SearchError::DUPLICATE_DOCUMENT_ID, "duplicate id"s);
+
+    const Expected<void> invalid_word = server.TryAddDocument(2, "black cat\x12"s, DocumentStatus::ACTUAL, { 1 });
+    AssertEqual(invalid_word.GetError(), SearchError::INVALID_DOCUMENT_WORD, "control character in a document"s);
+
+    AssertEqual(server.GetDocumentCount(), 1, "rejected documents are not added"s);
+    Assert(server.TryAddDocument(2, "black cat"s, DocumentStatus::ACTUAL, { 1 }).HasValue(), "id of a rejected document stays free"s);
+
+    try
+    {
+        server.AddDocument(2, "grey cat"s, DocumentStatus::ACTUAL, { 1 });
+        Assert(false, "throwing wrapper reports the error"s);
+    }
+    catch (const std::invalid_argument& e)
+    {
+        AssertEqual(std::string(e.what()), GetErrorMessage(SearchError::DUPLICATE_DOCUMENT_ID), "message of the error code"s);
+    }
+}
+
+void TestTryFindTopDocumentsErrors()
+{
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, { 1 });
+
+    const std::vector<std::pair<std::string, SearchError>> bad_queries = {
+        { "cat --collar"s, SearchError::QUERY_DOUBLE_MINUS },
+        { "cat -"s, SearchError::QUERY_SINGLE_MINUS },
+        { "cat\x12"s, SearchError::QUERY_INVALID_WORD },
+    };
+    for (const auto& [query, error] : bad_queries)
+    {
+        const Expected<std::vector<Document>> result = server.TryFindTopDocuments(query);
+        Assert(!result, "query is rejected: "s + query);
+        AssertEqual(result.GetError(), error, "error code of the query: "s + query);
+        try
+        {
+            (void)server.FindTopDocuments(query);
+            Assert(false, "throwing wrapper reports the error: "s + query);
+        }
+        catch (const std::invalid_argument&)
+        {
+        }
+    }
+
+    const Expected<std::vector<Document>> result = server.TryFindTopDocuments("cat -dog"s);
+    Assert(result.HasValue(), "valid query has a value"s);
+    AssertEqual(result.GetValue().size(), 1u, "valid query finds the document"s);
+    AssertEqual(GetDocumentIds(result.GetValue()), GetDocumentIds(server.FindTopDocuments("cat -dog"s)), "both APIs agree"s);
+}
+
+//      .  ,   
+std::vector<std::string> MakeTestDocumentWords(int document_id)
+{
+    static const std::vector<std::string> dictionary = { "cat"s, "dog"s, "bird"s, "fish"s, "tail"s, "collar"s, "white"s, "black"s };
+    std::vector<std::string> words;
+    const int length = 2 + document_id % 5;
+    for (int i = 0; i < length; ++i)
+    {
+        words.push_back(dictionary[(document_id * 7 + i * i * 3 + i) % dictionary.size()]);
+    }
+    return words;
+}
+
+std::string JoinWords(const std::vector<std::string>& words)
+{
+    std::string text;
+    for (const std::string& word : words)
+    {
+        text += (text.empty() ? ""s : " "s) + word;
+    }
+    return text;
+}
+
+// TF-IDF     -,      
+double ComputeReferenceTfIdf(const std::vector<std::vector<std::string>>& documents, int document_id,
+    const std::vector<std::string>& query_words)
+{
+    const std::vector<std::string>& words = documents[document_id];
+    double relevance = 0.0;
+    for (const std::string& query_word : query_words)
+    {
+        const auto term_count = std::count(words.begin(), words.end(), query_word);
+        if (term_count == 0)
+        {
+            continue;
+        }
+        const auto document_freq = std::count_if(documents.begin(), documents.end(), [&query_word](const std::vector<std::string>& document) {
+            return std::find(document.begin(), document.end(), query_word) != document.end();
+            });
+        relevance += static_cast<double>(term_count) / words.size() * std::log(static_cast<double>(documents.size()) / document_freq);
+    }
+    return relevance;
+}
+
+void TestFrozenSegmentsKeepScores()
+{
+    SearchServer server(""s);
+    std::vector<std::vector<std::string>> documents;
+    //   ,      ,    
+    const int document_count = 5 * 1024 + 100;
+    for (int id = 0; id < document_count; ++id)
+    {
+        documents.push_back(MakeTestDocumentWords(id));
+        server.AddDocument(id, JoinWords(documents.back()), DocumentStatus::ACTUAL, { id % 5 });
+    }
+
+    const std::vector<std::vector<std::string>> queries = { { "cat"s }, { "white"s, "tail"s }, { "fish"s, "collar"s, "dog"s } };
+    std::vector<std::vector<Document>> first_results;
+    for (const std::vector<std::string>& query : queries)
+    {
+        const std::vector<Document> found = server.FindTopDocuments(JoinWords(query));
+        AssertEqual(found.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT), "query "s + JoinWords(query));
+        for (const Document& document : found)
+        {
+            const double reference = ComputeReferenceTfIdf(documents, document.id, query);
+            Assert(std::abs(document.relevance - reference) <= 1e-12 * std::max(1.0, reference),
+                "relevance matches the direct TF-IDF for query "s + JoinWords(query));
+        }
+        first_results.push_back(found);
+    }
+
+    //        ,   
+    Assert(server.WaitForMerges() > 0, "frozen segments were merged"s);
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        const std::vector<Document> found = server.FindTopDocuments(JoinWords(queries[i]));
+        AssertEqual(GetDocumentIds(found), GetDocumentIds(first_results[i]), "same documents after merge"s);
+        for (size_t j = 0; j < found.size(); ++j)
+        {
+            Assert(found[j].relevance == first_results[i][j].relevance, "same relevance after merge"s);
+        }
+    }
+}
+
+void TestFreezeBoundaryKeepsScores()
+{
+    //           
+    SearchServer server(""s);
+    std::vector<std::vector<std::string>> documents;
+    for (int id = 0; id < 1023; ++id)
+    {
+        documents.push_back(MakeTestDocumentWords(id));
+        server.AddDocument(id, JoinWords(documents.back()), DocumentStatus::ACTUAL, { 0 });
+    }
+    const auto is_document_5 = [](int document_id, DocumentStatus, int) {
+        return document_id == 5;
+    };
+    const std::vector<std::string> query = MakeTestDocumentWords(5);
+    const double before = server.FindTopDocuments(JoinWords(query), is_document_5).at(0).relevance;
+    Assert(std::abs(before - ComputeReferenceTfIdf(documents, 5, query)) < 1e-12, "mutable segment relevance"s);
+
+    documents.push_back({ "zebra"s });
+    server.AddDocument(1023, "zebra"s, DocumentStatus::ACTUAL, { 0 });
+    const double after = server.FindTopDocuments(JoinWords(query), is_document_5).at(0).relevance;
+    Assert(std::abs(after - ComputeReferenceTfIdf(documents, 5, query)) < 1e-12, "frozen segment relevance"s);
+}
+
+void TestConcurrentAddAndFind()
+{
+    SearchServer server(""s);
+    const int document_count = 3000;
+    std::atomic<bool> done = false;
+    std::thread writer([&server, &done] {
+        for (int id = 0; id < document_count; ++id)
+        {
+            server.AddDocument(id, JoinWords(MakeTestDocumentWords(id)), DocumentStatus::ACTUAL, { 0 });
+        }
+        done = true;
+        });
+    int last_count = 0;
+    while (!done)
+    {
+        for (const Document& document : server.FindTopDocuments("cat dog"s))
+        {
+            const auto [words, status] = server.MatchDocument("cat dog"s, document.id);
+            Assert(!words.empty(), "found document matches the query"s);
+        }
+        const int count = server.GetDocumentCount();
+        Assert(count >= last_count, "document count does not decrease"s);
+        last_count = count;
+    }
+    writer.join();
+    AssertEqual(server.GetDocumentCount(), document_count, "all documents are added"s);
+}
+
+void TestShardedMatchesSingleServer()
+{
+    SearchServer single(""s);
+    ShardedSearchServer sharded(""s, 4);
+    for (int id = 0; id < 2000; ++id)
+    {
+        const std::string text = JoinWords(MakeTestDocumentWords(id));
+        single.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 5 });
+        sharded.AddDocument(id, text, DocumentStatus::ACTUAL, { id % 5 });
+    }
+    AssertEqual(sharded.GetDocumentCount(), single.GetDocumentCount(), "document count"s);
+
+    //       ,   - 
+    for (const std::string& query : { "cat"s, "white tail"s, "fish collar dog"s, "bird -cat"s, "black white -dog -fish"s })
+    {
+        const std::vector<Document> expected = single.FindTopDocuments(query);
+        const std::vector<Document> found = sharded.FindTopDocuments(query);
+        AssertEqual(found.size(), expected.size(), "result size for query "s + query);
+        for (size_t i = 0; i < found.size(); ++i)
+        {
+            Assert(found[i].relevance == expected[i].relevance, "same relevance at each rank for query "s + query);
+        }
+        for (const Document& document : found)
+        {
+            const auto is_document = [id = document.id](int document_id, DocumentStatus, int) {
+                return document_id == id;
+            };
+            Assert(single.FindTopDocuments(query, is_document).at(0).relevance == document.relevance,
+                "same relevance of the single server document for query "s + query);
+        }
+    }
+
+    //              
+    for (int attempt = 0; attempt < 20; ++attempt)
+    {
+        try
+        {
+            (void)sharded.FindTopDocuments("cat dog "s + std::string(100, 's'), [](int document_id, DocumentStatus, int) {
+                if (document_id % 4 == 1)
+                {
+                    throw std::runtime_error("predicate"s);
+                }
+                return true;
+                });
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+    }
+    AssertEqual(sharded.FindTopDocuments("cat"s).size(), single.FindTopDocuments("cat"s).size(), "server works after a failed query"s);
+}
+
+void TestQueryControlStopsSearch()
+{
+    SearchServer server(""s);
+    for (int id = 0; id < 3000; ++id)
+    {
+        server.AddDocument(id, JoinWords(MakeTestDocumentWords(id)), DocumentStatus::ACTUAL, { 0 });
+    }
+    const auto all_documents = [](int, DocumentStatus, int) {
+        return true;
+    };
+
+    const Expected<SearchResult> unbounded = server.TryFindTopDocuments("cat -dog"s, all_documents, QueryControl{});
+    Assert(unbounded.HasValue() && unbounded.GetValue().exhaustive, "query without limits is exhaustive"s);
+    AssertEqual(GetDocumentIds(unbounded.GetValue().documents), GetDocumentIds(server.FindTopDocuments("cat -dog"s, all_documents)),
+        "query without limits finds the same documents"s);
+
+    QueryControl cancelled;
+    cancelled.cancellation.emplace().Cancel();
+    const Expected<SearchResult> cancelled_result = server.TryFindTopDocuments("cat"s, all_documents, cancelled);
+    Assert(cancelled_result.HasValue() && !cancelled_result.GetValue().exhaustive, "cancelled query is not exhaustive"s);
+    Assert(cancelled_result.GetValue().documents.empty(), "query cancelled before start sees no postings"s);
+
+    QueryControl expired;
+    expired.deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    const Expected<SearchResult> expired_result = server.TryFindTopDocuments("cat"s, all_documents, expired);
+    Assert(expired_result.HasValue() && !expired_result.GetValue().exhaustive, "expired query is not exhaustive"s);
+    Assert(expired_result.GetValue().documents.empty(), "expired query sees no postings"s);
+
+    //        -
+    QueryControl budget;
+    budget.postings_budget = 100;
+    const Expected<SearchResult> partial = server.TryFindTopDocuments("cat -dog"s, all_documents, budget);
+    Assert(partial.HasValue() && !partial.GetValue().exhaustive, "query over the budget is not exhaustive"s);
+    Assert(!partial.GetValue().documents.empty(), "postings within the budget are ranked"s);
+    for (const Document& document : partial.GetValue().documents)
+    {
+        const std::vector<std::string> words = MakeTestDocumentWords(document.id);
+        Assert(std::count(words.begin(), words.end(), "dog"s) == 0, "minus word excludes documents from a partial result"s);
+    }
+
+    QueryControl large_budget;
+    large_budget.postings_budget = 1000000;
+    Assert(server.TryFindTopDocuments("cat"s, all_documents, large_budget).GetValue().exhaustive,
+        "budget larger than the postings is exhaustive"s);
+}
+
+void TestShardedAsyncSearch()
+{
+    ShardedSearchServer server(""s, 4);
+    for (int id = 0; id < 3000; ++id)
+    {
+        server.AddDocument(id, JoinWords(MakeTestDocumentWords(id)), DocumentStatus::ACTUAL, { id % 3 });
+    }
+
+    const std::vector<std::string> queries = { "cat"s, "white tail"s, "fish -collar"s, "bird black -dog"s };
+    std::vector<std::future<Expected<SearchResult>>> results;
+    for (int repeat = 0; repeat < 10; ++repeat)
+    {
+        for (const std::string& query : queries)
+        {
+            results.push_back(server.FindTopDocumentsAsync(query));
+        }
+    }
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Expected<SearchResult> result = results[i].get();
+        const std::string& query = queries[i % queries.size()];
+        Assert(result.HasValue() && result.GetValue().exhaustive, "async query without limits is exhaustive: "s + query);
+        const std::vector<Document> expected = server.FindTopDocuments(query);
+        AssertEqual(result.GetValue().documents.size(), expected.size(), "async query finds the same documents: "s + query);
+        for (size_t j = 0; j < expected.size(); ++j)
+        {
+            Assert(result.GetValue().documents[j].relevance == expected[j].relevance, "async query has the same relevance: "s + query);
+        }
+    }
+
+    Expected<SearchResult> error = server.FindTopDocumentsAsync("cat --dog"s).get();
+    Assert(!error, "async query reports a parse error"s);
+    AssertEqual(error.GetError(), SearchError::QUERY_DOUBLE_MINUS, "async parse error code"s);
+
+    QueryControl cancelled;
+    cancelled.cancellation.emplace().Cancel();
+    const Expected<SearchResult> cancelled_result = server.FindTopDocumentsAsync("cat"s, cancelled).get();
+    Assert(cancelled_result.HasValue() && !cancelled_result.GetValue().exhaustive, "cancelled async query is not exhaustive"s);
+    Assert(cancelled_result.GetValue().documents.empty(), "cancelled async query sees no postings"s);
+
+    QueryControl expired;
+    expired.deadline = std::chrono::steady_clock::now();
+    const Expected<SearchResult> expired_result = server.FindTopDocumentsAsync("cat"s, expired).get();
+    Assert(expired_result.HasValue() && !expired_result.GetValue().exhaustive, "expired async query is not exhaustive"s);
+
+    //    :  ,   
+    QueryControl in_flight;
+    const CancellationToken& token = in_flight.cancellation.emplace();
+    std::future<Expected<SearchResult>> running = server.FindTopDocumentsAsync("cat dog bird"s, in_flight);
+    token.Cancel();
+    Assert(running.get().HasValue(), "query cancelled in flight still returns a result"s);
+}
+
+void TestImpactOrderedBudget()
+{
+    SearchServer impact_server(""s, PostingLayout::IMPACT_ORDERED);
+    SearchServer document_server(""s);
+    ShardedSearchServer sharded_server(""s, 2, PostingLayout::IMPACT_ORDERED);
+    for (int id = 0; id < 3000; ++id)
+    {
+        const std::string text = JoinWords(MakeTestDocumentWords(id));
+        impact_server.AddDocument(id, text, DocumentStatus::ACTUAL, { 0 });
+        document_server.AddDocument(id, text, DocumentStatus::ACTUAL, { 0 });
+        sharded_server.AddDocument(id, text, DocumentStatus::ACTUAL, { 0 });
+    }
+    const auto all_documents = [](int, DocumentStatus, int) {
+        return true;
+    };
+
+    //      :   ,    
+    for (const std::string& query : { "cat"s, "white tail -dog"s, "fish collar bird"s })
+    {
+        const std::vector<Document> expected = impact_server.FindTopDocuments(query);
+        const Expected<SearchResult> unbounded = impact_server.TryFindTopDocuments(query, all_documents, QueryControl{});
+        Assert(unbounded.GetValue().exhaustive, "unbounded query is exhaustive: "s + query);
+        AssertEqual(GetDocumentIds(unbounded.GetValue().documents), GetDocumentIds(expected), "unbounded query documents: "s + query);
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            Assert(unbounded.GetValue().documents[i].relevance == expected[i].relevance, "unbounded query relevance: "s + query);
+        }
+        const std::vector<Document> sharded = sharded_server.FindTopDocuments(query);
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            Assert(sharded[i].relevance == expected[i].relevance, "unbounded sharded query relevance: "s + query);
+        }
+    }
+
+    //          
+    QueryControl budget;
+    budget.postings_budget = 200;
+    const std::vector<Document> expected = impact_server.FindTopDocuments("cat"s);
+    const Expected<SearchResult> impact = impact_server.TryFindTopDocuments("cat"s, all_documents, budget);
+    const Expected<SearchResult> document = document_server.TryFindTopDocuments("cat"s, all_documents, budget);
+    Assert(!impact.GetValue().exhaustive && !document.GetValue().exhaustive, "budget stops both layouts"s);
+    AssertEqual(impact.GetValue().documents.size(), expected.size(), "impact ordered result size"s);
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        Assert(impact.GetValue().documents[i].relevance == expected[i].relevance, "impact order finds the best documents"s);
+    }
+
+    const Expected<SearchResult> sharded = sharded_server.TryFindTopDocuments("cat"s, all_documents, budget);
+    Assert(!sharded.GetValue().exhaustive, "budget stops the shards"s);
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        Assert(sharded.GetValue().documents.at(i).relevance == expected[i].relevance, "sharded impact order finds the best documents"s);
+    }
+}
+
+void TestPhraseQueries()
+{
+    //        ,   
+    SearchServer server("and in"s);
+    const std::vector<std::string> texts = { "white cat and black collar"s, "black cat and white collar"s, "cat white tail"s };
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i)
+    {
+        server.AddDocument(i, texts[i], DocumentStatus::ACTUAL, { 0 });
+    }
+    for (int id = 100; id < 1200; ++id)
+    {
+        server.AddDocument(id, "filler text"s, DocumentStatus::ACTUAL, { 0 });
+    }
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i)
+    {
+        server.AddDocument(2000 + i, texts[i], DocumentStatus::ACTUAL, { 0 });
+    }
+    const auto sorted_ids = [&server](const std::string& query) {
+        std::vector<int> ids = GetDocumentIds(server.FindTopDocuments(query));
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+
+    AssertEqual(sorted_ids("\"white cat\""s), std::vector<int>{ 0, 2000 }, "plus phrase"s);
+    AssertEqual(sorted_ids("\"cat white\""s), std::vector<int>{ 2, 2002 }, "word order matters"s);
+    AssertEqual(sorted_ids("\"white collar\" \"black cat\""s), std::vector<int>{ 1, 2001 }, "all plus phrases are required"s);
+    AssertEqual(sorted_ids("cat -\"white cat\""s), std::vector<int>{ 1, 2, 2001, 2002 }, "minus phrase"s);
+    AssertEqual(sorted_ids("cat -\"black cat\" -\"white tail\""s), std::vector<int>{ 0, 2000 }, "several minus phrases"s);
+    AssertEqual(sorted_ids("\"cat in black\""s), std::vector<int>{ 0, 2000 }, "stop word inside a phrase matches any word"s);
+    AssertEqual(sorted_ids("\"and white cat\""s), std::vector<int>{ 0, 2000 }, "stop words at the ends are dropped"s);
+    Assert(server.FindTopDocuments("\"collar white\""s).empty(), "no document has the phrase"s);
+    Assert(server.FindTopDocuments("\"white dog\""s).empty(), "phrase with an unknown word"s);
+
+    const auto [words, status] = server.MatchDocument("\"white cat\""s, 2001);
+    Assert(words.empty(), "document without the phrase does not match"s);
+    const auto [phrase_words, phrase_status] = server.MatchDocument("\"white cat\""s, 0);
+    AssertEqual(phrase_words, std::vector<std::string>{ "cat"s, "white"s }, "phrase words of a matching document"s);
+    const auto [minus_words, minus_status] = server.MatchDocument("cat -\"white cat\""s, 2000);
+    Assert(minus_words.empty(), "minus phrase excludes the document"s);
+
+    AssertEqual(server.TryFindTopDocuments("\"white cat"s).GetError(), SearchError::QUERY_UNTERMINATED_PHRASE, "unterminated phrase"s);
+}
+
+// BM25     -, IDF -   .   
+//   ranker_ids,     ,     
+double ComputeReferenceBm25(const std::vector<std::vector<std::string>>& documents, const std::vector<int>& ranker_ids,
+    int document_id, const std::vector<std::string>& query_words)
+{
+    const double k1 = 1.2;
+    const double b = 0.75;
+    size_t total_length = 0;
+    size_t added_count = 0;
+    for (const int id : ranker_ids)
+    {
+        total_length += documents[id].size();
+        ++added_count;
+        if (id == document_id)
+        {
+            break;
+        }
+    }
+    const double average_length = static_cast<double>(total_length) / added_count;
+    const std::vector<std::string>& words = documents[document_id];
+    double relevance = 0.0;
+    for (const std::string& query_word : query_words)
+    {
+        const auto term_count = static_cast<double>(std::count(words.begin(), words.end(), query_word));
+        if (term_count == 0)
+        {
+            continue;
+        }
+        const auto document_freq = static_cast<double>(std::count_if(documents.begin(), documents.end(), [&query_word](const std::vector<std::string>& document) {
+            return std::find(document.begin(), document.end(), query_word) != document.end();
+            }));
+        const double term_weight = std::log(1.0 + (documents.size() - document_freq + 0.5) / (document_freq + 0.5));
+        relevance += term_count * (k1 + 1.0) / (term_count + k1 * (1.0 - b + b * words.size() / average_length)) * term_weight;
+    }
+    return relevance;
+}
+
+void TestRankers()
+{
+    const TfIdfRanker tf_idf;
+    Assert(tf_idf.ComputePostingWeight(3, 7) == 1.0 / 7 + 1.0 / 7 + 1.0 / 7, "TF is a sum of 1 / length per occurrence"s);
+
+    try
+    {
+        Bm25Ranker(1.2, 1.5);
+        Assert(false, "b outside [0, 1] must throw"s);
+    }
+    catch (const std::invalid_argument&)
+    {
+    }
+
+    const int document_count = 2000;
+    const int shard_count = 3;
+    BasicSearchServer<Bm25Ranker> server(""s);
+    BasicShardedSearchServer<Bm25Ranker> sharded(""s, shard_count);
+    std::vector<std::vector<std::string>> documents;
+    std::vector<int> ids;
+    std::vector<std::vector<int>> shard_ids(shard_count);
+    for (int id = 0; id < document_count; ++id)
+    {
+        documents.push_back(MakeTestDocumentWords(id));
+        ids.push_back(id);
+        shard_ids[id % shard_count].push_back(id);
+        server.AddDocument(id, JoinWords(documents.back()), DocumentStatus::ACTUAL, { 0 });
+        sharded.AddDocument(id, JoinWords(documents.back()), DocumentStatus::ACTUAL, { 0 });
+    }
+    for (const std::vector<std::string>& query : { std::vector<std::string>{ "cat"s }, std::vector<std::string>{ "white"s, "tail"s, "fish"s } })
+    {
+        for (const Document& document : server.FindTopDocuments(JoinWords(query)))
+        {
+            const double reference = ComputeReferenceBm25(documents, ids, document.id, query);
+            Assert(std::abs(document.relevance - reference) <= 1e-12 * std::max(1.0, reference), "BM25 relevance: "s + JoinWords(query));
+        }
+        // IDF   ,     -    
+        for (const Document& document : sharded.FindTopDocuments(JoinWords(query)))
+        {
+            const double reference = ComputeReferenceBm25(documents, shard_ids[document.id % shard_count], document.id, query);
+            Assert(std::abs(document.relevance - reference) <= 1e-12 * std::max(1.0, reference), "sharded BM25 relevance: "s + JoinWords(query));
+        }
+    }
+
+    //   :    ,      
+    BasicSearchServer<Bm25Ranker> saturation(""s);
+    saturation.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 0 });
+    saturation.AddDocument(2, "cat cat cat cat cat cat dog"s, DocumentStatus::ACTUAL, { 0 });
+    saturation.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, { 0 });
+    const std::vector<Document> found = saturation.FindTopDocuments("cat"s);
+    AssertEqual(GetDocumentIds(found), std::vector<int>{ 2, 1 }, "both documents with the word are found"s);
+    Assert(found[0].relevance < 2.0 * found[1].relevance, "repeated words saturate"s);
+}
+
+void TestPrefixExpansion()
+{
+    SearchServer server(""s);
+    //          
+    int id = 0;
+    for (int i = 0; i < 3000; ++i)
+    {
+        server.AddDocument(id++, "pa"s + std::to_string(1000 + i) + " rare"s, DocumentStatus::ACTUAL, { 0 });
+    }
+    for (int i = 0; i < 200; ++i)
+    {
+        server.AddDocument(id++, "pzcat pzdog"s, DocumentStatus::ACTUAL, { 0 });
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        server.AddDocument(id++, "pzbird"s, DocumentStatus::ACTUAL, { 0 });
     }
+    const int frequent_first_id = 3000;
 
-    std::vector<Document> FindTopDocuments(const std::string& raw_query) const
+    for (const Document& document : server.FindTopDocuments("p*"s))
     {
-        return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+        Assert(document.id >= frequent_first_id, "frequent terms are chosen regardless of their alphabetical place"s);
     }
+    Assert(!server.FindTopDocuments("pz*"s).empty(), "prefix with only frequent terms"s);
+    Assert(server.FindTopDocuments("rare -p*"s).size() == MAX_RESULT_DOCUMENT_COUNT, "minus prefix removes only the chosen terms"s);
+    Assert(server.FindTopDocuments("pzcat -pz*"s).empty(), "minus prefix removes documents with frequent terms"s);
 
-    int GetDocumentCount() const
+    //        ,     
+    for (int i = 0; i < 300; ++i)
     {
-        return documents_.size();
+        server.AddDocument(id++, "pbnew"s, DocumentStatus::ACTUAL, { 0 });
     }
+    const int last_id = id - 1;
+    const auto [words, status] = server.MatchDocument("p*"s, last_id);
+    AssertEqual(words, std::vector<std::string>{ "pbnew"s }, "new frequent term is chosen"s);
 
-    int GetDocumentId(int index) const
+    //  MAX_PREFIX_EXPANSION   ;    -   
+    SearchServer ties(""s);
+    for (int i = 0; i < 40; ++i)
     {
-        if (index >= 0 && index < GetDocumentCount()) 
+        const std::string word = "t"s + std::to_string(100 + i);
+        for (int copy = 0; copy < (i % 2 == 0 ? 3 : 1); ++copy)
         {
-            return document_ids_[index];
+            ties.AddDocument(i * 10 + copy, word, DocumentStatus::ACTUAL, { 0 });
         }
-        throw std::out_of_range("       "s);
     }
-
-    std::tuple<std::vector<std::string>, DocumentStatus>MatchDocument(const std::string& raw_query, int document_id) const
+    std::vector<std::string> chosen;
+    for (int i = 0; i < 40; ++i)
     {
-         Query query = ParseQuery(raw_query);
-         std::vector<std::string> matched_words;
-        for (const std::string& word : query.plus_words) 
+        const auto [matched, matched_status] = ties.MatchDocument("t*"s, i * 10);
+        if (!matched.empty())
         {
-            if (word_to_document_freqs_.count(word) == 0) 
-            {
-                continue;
-            }
-            if (word_to_document_freqs_.at(word).count(document_id))
-            {
-                matched_words.push_back(word);
-            }
+            chosen.push_back(matched[0]);
         }
-        for (const std::string& word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) 
-            {
-                continue;
-            }
-            if (word_to_document_freqs_.at(word).count(document_id)) 
-            {
-                matched_words.clear();
-                break;
-            }
-        }        
-        return { matched_words, documents_.at(document_id).status };
     }
-
-private:
-    struct DocumentData 
+    std::vector<std::string> expected;
+    for (int i = 0; i < 32; i += 2)
     {
-        int rating;
-        DocumentStatus status;
-    };
-    const std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::vector<int> document_ids_;
+        expected.push_back("t"s + std::to_string(100 + i));
+    }
+    AssertEqual(chosen, expected, "most frequent terms, ties in alphabetical order"s);
+}
 
-    bool IsStopWord(const std::string& word) const
+//    CP1251  UTF-8:    CP1251,     .
+//  -,   ,    0x80   Latin-1 (,    )
+std::string ToUtf8(const std::string& cp1251_text)
+{
+    std::string text;
+    for (const char c : cp1251_text)
     {
-        return stop_words_.count(word) > 0;
+        const unsigned char byte = static_cast<unsigned char>(c);
+        uint32_t code_point = byte;
+        if (byte >= 0xC0)
+        {
+            code_point = 0x410 + (byte - 0xC0);
+        }
+        else if (byte == 0xA8 || byte == 0xB8)
+        {
+            code_point = byte == 0xA8 ? 0x401 : 0x451;
+        }
+        if (code_point < 0x80)
+        {
+            text += static_cast<char>(code_point);
+        }
+        else
+        {
+            text += static_cast<char>(0xC0 | (code_point >> 6));
+            text += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
     }
+    return text;
+}
 
-    static bool IsValidWord(const std::string& word)
+void TestEditDistanceInCodePoints()
+{
+    const auto distance = [](const std::string& lhs, const std::string& rhs) {
+        return ComputeEditDistance(DecodeSymbols(lhs), DecodeSymbols(rhs), 3);
+    };
+    AssertEqual(distance(""s, ""s), 1, "CP1251 substitution"s);
+    AssertEqual(distance(ToUtf8(""s), ToUtf8(""s)), 1, "UTF-8 substitution is one edit"s);
+    AssertEqual(distance(ToUtf8(""s), ToUtf8(""s)), 1, "UTF-8 transposition is one edit"s);
+    AssertEqual(distance(ToUtf8(""s), ToUtf8(""s) + "x"s), 2, "substitution and insertion"s);
+    AssertEqual(distance(ToUtf8(""s), ToUtf8(""s)), 1, "different letters with a common byte"s);
+    AssertEqual(DecodeSymbols(ToUtf8(""s)).size(), 8u, "one symbol per UTF-8 letter"s);
+    AssertEqual(DecodeSymbols(""s).size(), 8u, "one symbol per CP1251 byte"s);
+    Assert(DecodeSymbols("\xE0"s) != DecodeSymbols("\xC3\xA0"s), "invalid byte differs from the code point of the same value"s);
+    AssertEqual(DecodeSymbols("\xED\xA0\x80"s).size(), 3u, "encoded surrogate is three invalid bytes"s);
+
+    //       UTF-8    PREFIX_LENGTH 
+    for (const bool is_utf8 : { false, true })
     {
-        return none_of(word.begin(), word.end(), [](char c) 
-            {
-            return c >= '\0' && c < ' ';
-            });
+        const auto encode = [is_utf8](const std::string& text) {
+            return is_utf8 ? ToUtf8(text) : text;
+        };
+        SearchServer server(""s, PostingLayout::DOCUMENT_ORDERED, TfIdfRanker(), is_utf8 ? TextEncoding::UTF8 : TextEncoding::CP1251);
+        server.AddDocument(1, encode("    "s), DocumentStatus::ACTUAL, { 0 });
+        server.AddDocument(2, "white dog"s, DocumentStatus::ACTUAL, { 0 });
+        const std::string typo = encode(""s);
+        Assert(server.FindTopDocuments(typo).empty(), "no fuzzy matching by default"s);
+        server.SetFuzzyMatching(1);
+        AssertEqual(GetDocumentIds(server.FindTopDocuments(typo)), std::vector<int>{ 1 }, "one letter typo is found"s);
+        const std::string far_typo = encode(""s);
+        Assert(server.FindTopDocuments(far_typo).empty(), "two letter typo is beyond distance 1"s);
+        server.SetFuzzyMatching(2);
+        AssertEqual(GetDocumentIds(server.FindTopDocuments(far_typo)), std::vector<int>{ 1 }, "two letter typo at distance 2"s);
     }
+}
 
-    
+void TestNormalizeText()
+{
+    AssertEqual(NormalizeText(" , !  5"s, TextEncoding::CP1251), "       5"s, "CP1251 folding"s);
+    AssertEqual(NormalizeText(ToUtf8(" , !"s), TextEncoding::UTF8), ToUtf8("    "s), "UTF-8 folding"s);
+    AssertEqual(NormalizeText("\xC3\x80 \xC5\x81 \xC5\xB8"s, TextEncoding::UTF8), "\xC3\xA0 \xC5\x82 \xC3\xBF"s, "Latin letters in UTF-8"s);
+    AssertEqual(NormalizeText("a\xC2\xAB" "b\xE2\x80\x94" "c"s, TextEncoding::UTF8), "a  b   c"s, "Unicode punctuation becomes spaces"s);
+    AssertEqual(NormalizeText("x\x12y\tz"s, TextEncoding::UTF8), "x\x12y\tz"s, "control characters stay for the tokenizer"s);
 
-    std::vector<std::string>SplitIntoWordsNoStop(const std::string& text) const 
+    //    UTF-8     
+    AssertEqual(NormalizeText(ToUtf8(""s) + "\xFF"s + ToUtf8("Ϩ"s), TextEncoding::UTF8), ToUtf8(""s) + "\xFF"s + ToUtf8(""s),
+        "invalid byte passes through unchanged"s);
+    AssertEqual(NormalizeText("\xED\xA0\x80" "A\xE0\x80\x80"s, TextEncoding::UTF8), "\xED\xA0\x80" "a\xE0\x80\x80"s,
+        "surrogates and overlong forms pass through unchanged"s);
+    AssertEqual(NormalizeText(ToUtf8(""s) + "\xD0"s, TextEncoding::UTF8), ToUtf8(""s) + "\xD0"s, "truncated sequence at the end"s);
+
+    const std::string query = "- -- \", \". * -* * a-b - don't 'a'"s;
+    AssertEqual(NormalizeText(query, TextEncoding::CP1251), "                  a-b - don't  a "s,
+        "document keeps only joiners"s);
+    AssertEqual(NormalizeText(query, TextEncoding::CP1251, true), "- -- \"  \"  * -* * a-b - don't  a "s,
+        "query keeps its syntax"s);
+    AssertEqual(NormalizeText(ToUtf8(query), TextEncoding::UTF8, true), ToUtf8(NormalizeText(query, TextEncoding::CP1251, true)),
+        "both encodings agree"s);
+    AssertEqual(NormalizeText("a-\xC2\xAB"s, TextEncoding::UTF8), "a   "s, "hyphen before punctuation is not a joiner"s);
+
+    for (const std::string& text : { "  , \"\""s, "ƨ ƻ"s })
     {
-         std::vector<std::string> words;
-        for (const std::string& word : SplitIntoWords(text))
-        {
-            if (!IsValidWord(word))
-            {
-               throw std::invalid_argument("   "s);
-            }
-            if (!IsStopWord(word))
-            {
-                words.push_back(word);
-            }
-        }        
-        return words;
+        const std::string normalized = NormalizeText(ToUtf8(text), TextEncoding::UTF8);
+        AssertEqual(normalized.size(), ToUtf8(text).size(), "length is kept"s);
+        AssertEqual(NormalizeText(normalized, TextEncoding::UTF8), normalized, "normalization is idempotent"s);
     }
+    AssertEqual(NormalizeText("ƨ ²"s, TextEncoding::CP1251), " "s, "CP1251 pairs that look like UTF-8"s);
 
-    static int ComputeAverageRating(const std::vector<int>& ratings) 
+    SearchServer cp1251_server("  "s, PostingLayout::DOCUMENT_ORDERED, TfIdfRanker(), TextEncoding::CP1251);
+    cp1251_server.AddDocument(1, " ,  ."s, DocumentStatus::ACTUAL, { 7 });
+    cp1251_server.AddDocument(2, "ƨ    "s, DocumentStatus::ACTUAL, { 5 });
+    AssertEqual(GetDocumentIds(cp1251_server.FindTopDocuments(""s)), std::vector<int>{ 1 }, "CP1251 query in upper case"s);
+    AssertEqual(GetDocumentIds(cp1251_server.FindTopDocuments(""s)), std::vector<int>{ 2 }, "CP1251 document in upper case"s);
+    Assert(cp1251_server.FindTopDocuments(""s).empty(), "stop words are normalized"s);
+    AssertEqual(std::get<0>(cp1251_server.MatchDocument("! ?"s, 1)), std::vector<std::string>{ ""s, ""s }, "matched words"s);
+
+    SearchServer utf8_server(ToUtf8("  "s));
+    utf8_server.AddDocument(1, ToUtf8("  , "s) + " \xFF"s, DocumentStatus::ACTUAL, { 1 });
+    AssertEqual(GetDocumentIds(utf8_server.FindTopDocuments(ToUtf8(" "s))), std::vector<int>{ 1 }, "UTF-8 document with a stray byte"s);
+    AssertEqual(GetDocumentIds(utf8_server.FindTopDocuments(ToUtf8("\"  \""s))), std::vector<int>{ 1 }, "UTF-8 phrase"s);
+}
+
+template <typename TestFunc>
+void RunTestImpl(TestFunc func, const std::string& test_name)
+{
+    func();
+    std::cerr << test_name << " Ok"s << std::endl;
+}
+
+#define RUN_TEST(func) RunTestImpl(func, #func)
+
+void TestSearchServer()
+{
+    RUN_TEST(TestSetDocumentStatus);
+    RUN_TEST(TestSetDocumentStatusInFrozenSegment);
+    RUN_TEST(TestTryAddDocumentErrors);
+    RUN_TEST(TestTryFindTopDocumentsErrors);
+    RUN_TEST(TestFrozenSegmentsKeepScores);
+    RUN_TEST(TestFreezeBoundaryKeepsScores);
+    RUN_TEST(TestConcurrentAddAndFind);
+    RUN_TEST(TestShardedMatchesSingleServer);
+    RUN_TEST(TestQueryControlStopsSearch);
+    RUN_TEST(TestShardedAsyncSearch);
+    RUN_TEST(TestImpactOrderedBudget);
+    RUN_TEST(TestPhraseQueries);
+    RUN_TEST(TestRankers);
+    RUN_TEST(TestPrefixExpansion);
+    RUN_TEST(TestEditDistanceInCodePoints);
+    RUN_TEST(TestNormalizeText);
+}
+#endif
+
+#ifdef SEARCH_BENCHMARK
+//       .    -DSEARCH_BENCHMARK,
+//      -DSEARCH_BENCHMARK_MAX_DOCUMENTS=N.
+//        ,      seed
+
+#ifndef SEARCH_BENCHMARK_MAX_DOCUMENTS
+#define SEARCH_BENCHMARK_MAX_DOCUMENTS 100000
+#endif
+
+struct CorpusConfig
+{
+    int dictionary_size = 50000;
+    int document_length = 20;
+    double zipf_exponent = 1.0;
+    //      -
+    int stop_word_count = 20;
+    int query_count = 2000;
+    int query_length = 4;
+    double minus_word_probability = 0.1;
+    double stop_word_probability = 0.1;
+    unsigned int seed = 42;
+};
+
+//    0..size-1  ,  1 / (rank + 1)^exponent
+class ZipfDistribution
+{
+public:
+    ZipfDistribution(int size, double exponent)
+        : cumulative_(size)
     {
-        if (ratings.empty())
+        double sum = 0.0;
+        for (int rank = 0; rank < size; ++rank)
         {
-            return 0;
+            sum += 1.0 / std::pow(rank + 1.0, exponent);
+            cumulative_[rank] = sum;
         }
-        int rating_sum = 0;
-        for (const int rating : ratings) 
+        for (double& value : cumulative_)
         {
-            rating_sum += rating;
+            value /= sum;
         }
-        return rating_sum / static_cast<int>(ratings.size());
     }
 
-    struct QueryWord
-    {        
-        std::string data;
-        bool is_minus;
-        bool is_stop;
-    };
+    template <typename Generator>
+    int operator()(Generator& generator) const
+    {
+        const double point = std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+        const auto it = std::lower_bound(cumulative_.begin(), cumulative_.end(), point);
+        return static_cast<int>(std::min<std::ptrdiff_t>(it - cumulative_.begin(), cumulative_.size() - 1));
+    }
 
-    
+private:
+    std::vector<double> cumulative_;
+};
 
-    QueryWord ParseQueryWord(std::string text) const
-    {        
-        bool is_minus = false;
-        if (text[0] == '-') 
-        {
-            is_minus = true;
-            text = text.substr(1);
-        }
-        if ( text[0] == '-')
+class SyntheticCorpus
+{
+public:
+    explicit SyntheticCorpus(const CorpusConfig& config)
+        : config_(config)
+        , zipf_(config.dictionary_size, config.zipf_exponent)
+        , generator_(config.seed)
+    {
+        dictionary_.reserve(config.dictionary_size);
+        for (int rank = 0; rank < config.dictionary_size; ++rank)
         {
-            throw std::invalid_argument("     "s);
+            dictionary_.push_back(MakeWord(rank));
         }
-        if (!IsValidWord(text)) 
-        {
-            throw std::invalid_argument("     "s);
-        }     
-        if (text.empty()) 
+    }
+
+    std::string GetStopWords() const
+    {
+        std::string stop_words;
+        for (int rank = 0; rank < config_.stop_word_count && rank < config_.dictionary_size; ++rank)
         {
-            throw std::invalid_argument("     "s);
+            stop_words += dictionary_[rank] + ' ';
         }
-        return{ text, is_minus, IsStopWord(text) };
+        return stop_words;
     }
 
-    struct Query
-    {        
-        std::set<std::string> plus_words ;
-        std::set<std::string> minus_words ;
-    };
-
-    Query ParseQuery(const std::string& text) const
-    {        
-        Query query;
-        for (const std::string& word : SplitIntoWords(text))
+    std::string NextDocument()
+    {
+        std::string document;
+        for (int i = 0; i < config_.document_length; ++i)
         {
-            QueryWord query_word = ParseQueryWord(word);
-            if (!query_word.is_stop)
+            if (i > 0)
             {
-                if (query_word.is_minus)
-                {
-                    query.minus_words.insert(query_word.data);
-                }
-                else
-                {
-                    query.plus_words.insert(query_word.data);
-                }
+                document += ' ';
             }
+            document += dictionary_[zipf_(generator_)];
         }
-        return query;
-    }
-
-    double ComputeWordInverseDocumentFreq(const std::string& word) const
-    {
-        return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+        return document;
     }
 
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const 
+    //   -, -  -. -    ,
+    //      
+    std::string NextQuery()
     {
-        std::map<int, double> document_to_relevance;
-        for (const std::string& word : query.plus_words)
+        std::bernoulli_distribution is_minus(config_.minus_word_probability);
+        std::bernoulli_distribution is_stop(config_.stop_word_probability);
+        std::string query;
+        for (int i = 0; i < config_.query_length; ++i)
         {
-            if (word_to_document_freqs_.count(word) == 0) 
+            if (i > 0)
             {
-                continue;
+                query += ' ';
             }
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
+            if (config_.stop_word_count > 0 && is_stop(generator_))
             {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating))
-                {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
-                }
+                query += dictionary_[std::uniform_int_distribution<int>(0, config_.stop_word_count - 1)(generator_)];
             }
-        }
-
-        for (const string& word : query.minus_words) 
-        {
-            if (word_to_document_freqs_.count(word) == 0)
+            else if (is_minus(generator_))
             {
-                continue;
+                query += '-' + dictionary_[std::uniform_int_distribution<int>(0, config_.dictionary_size - 1)(generator_)];
             }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word))
+            else
             {
-                document_to_relevance.erase(document_id);
+                query += dictionary_[zipf_(generator_)];
             }
         }
+        return query;
+    }
 
-        std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance) 
+    std::mt19937& GetGenerator()
+    {
+        return generator_;
+    }
+
+private:
+    //    ,   
+    static std::string MakeWord(int rank)
+    {
+        std::string word;
+        do
         {
-            matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
-        }
-        return matched_documents;
+            word += static_cast<char>('a' + rank % 26);
+            rank /= 26;
+        } while (rank > 0);
+        return word;
+    }
+
+    CorpusConfig config_;
+    ZipfDistribution zipf_;
+    std::mt19937 generator_;
+    std::vector<std::string> dictionary_;
+};
+
+//       .      ,
+//      
+double GetPeakMemoryMegabytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
     }
+    return 0.0;
+#elif defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#else
+    return 0.0;
+#endif
+}
+
+struct LatencyPercentiles
+{
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
 };
 
+LatencyPercentiles ComputePercentiles(std::vector<double> latencies)
+{
+    LatencyPercentiles result;
+    if (latencies.empty())
+    {
+        return result;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const auto at = [&latencies](double quantile)
+    {
+        const size_t index = static_cast<size_t>(std::ceil(quantile * latencies.size()));
+        return latencies[std::clamp<size_t>(index, 1, latencies.size()) - 1];
+    };
+    result.p50 = at(0.5);
+    result.p90 = at(0.9);
+    result.p99 = at(0.99);
+    result.max = latencies.back();
+    return result;
+}
+
+void PrintLatencies(const std::string& name, const LatencyPercentiles& latencies)
+{
+    std::cout << "  "s << name << " latency, us: p50 = "s << latencies.p50
+        << ", p90 = "s << latencies.p90
+        << ", p99 = "s << latencies.p99
+        << ", max = "s << latencies.max << std::endl;
+}
+
+void BenchmarkCorpus(int document_count, const CorpusConfig& config)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto to_microseconds = [](Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    };
+
+    SyntheticCorpus corpus(config);
+    SearchServer search_server(corpus.GetStopWords());
+
+    Clock::duration add_time{};
+    for (int document_id = 0; document_id < document_count; ++document_id)
+    {
+        const std::string document = corpus.NextDocument();
+        const auto start = Clock::now();
+        search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, { document_id % 10 });
+        add_time += Clock::now() - start;
+    }
 
+    size_t found_count = 0;
+    std::vector<double> find_latencies;
+    std::vector<double> match_latencies;
+    find_latencies.reserve(config.query_count);
+    match_latencies.reserve(config.query_count);
+    std::uniform_int_distribution<int> random_document(0, document_count - 1);
+    for (int i = 0; i < config.query_count; ++i)
+    {
+        const std::string query = corpus.NextQuery();
 
+        auto start = Clock::now();
+        found_count += search_server.FindTopDocuments(query).size();
+        find_latencies.push_back(to_microseconds(Clock::now() - start));
 
+        const int document_id = random_document(corpus.GetGenerator());
+        start = Clock::now();
+        const auto [words, status] = search_server.MatchDocument(query, document_id);
+        match_latencies.push_back(to_microseconds(Clock::now() - start));
+        found_count += words.size();
+    }
 
+    const double add_seconds = std::chrono::duration<double>(add_time).count();
+    std::cout << "documents = "s << document_count
+        << ", dictionary = "s << config.dictionary_size
+        << ", document length = "s << config.document_length << std::endl;
+    std::cout << "  AddDocument: "s << document_count / add_seconds << " docs/s, "s
+        << document_count * static_cast<double>(config.document_length) / add_seconds << " words/s"s << std::endl;
+    PrintLatencies("FindTopDocuments"s, ComputePercentiles(std::move(find_latencies)));
+    PrintLatencies("MatchDocument"s, ComputePercentiles(std::move(match_latencies)));
+    std::cout << "  peak memory: "s << GetPeakMemoryMegabytes() << " MB (matched "s << found_count << ")"s << std::endl;
+    const MemoryStats memory = search_server.GetMemoryStats();
+    std::cout << "  index memory, bytes: total = "s << memory.GetTotal()
+        << ", stop words = "s << memory.stop_words
+        << ", dictionary = "s << memory.dictionary
+        << ", postings = "s << memory.postings
+        << ", positions = "s << memory.positions
+        << ", documents = "s << memory.documents
+        << ", document ids = "s << memory.document_ids << std::endl;
+#ifdef SEARCH_SERVER_TRACING
+    search_server.GetQueryStatistics().PrintHistograms(std::cout);
+#endif
+}
 
-void PrintDocument(const Document& document)
+//  FindTopDocuments     TF-IDF    
+template <typename Ranker>
+void BenchmarkRanker(const std::string& name, int document_count, const CorpusConfig& config)
 {
-    std::cout << "{ "s
-        << "document_id = "s << document.id << ", "s
-        << "relevance = "s << document.relevance << ", "s
-        << "rating = "s << document.rating << " }"s << std::endl;
+    using Clock = std::chrono::steady_clock;
+    SyntheticCorpus corpus(config);
+    SearchServer tf_idf_server(corpus.GetStopWords());
+    BasicSearchServer<Ranker> search_server(corpus.GetStopWords());
+    for (int document_id = 0; document_id < document_count; ++document_id)
+    {
+        const std::string document = corpus.NextDocument();
+        tf_idf_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, { document_id % 10 });
+        search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, { document_id % 10 });
+    }
+
+    size_t found_count = 0;
+    size_t same_count = 0;
+    std::vector<double> find_latencies;
+    find_latencies.reserve(config.query_count);
+    for (int i = 0; i < config.query_count; ++i)
+    {
+        const std::string query = corpus.NextQuery();
+        const auto start = Clock::now();
+        const std::vector<Document> documents = search_server.FindTopDocuments(query);
+        find_latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        found_count += documents.size();
+        for (const Document& document : tf_idf_server.FindTopDocuments(query))
+        {
+            same_count += std::count_if(documents.begin(), documents.end(), [&document](const Document& found)
+                {
+                    return found.id == document.id;
+                });
+        }
+    }
+    std::cout << "  "s << name << ": found "s << found_count << ", also in TF-IDF top "s << same_count << std::endl;
+    PrintLatencies("  FindTopDocuments"s, ComputePercentiles(std::move(find_latencies)));
 }
 
-void PrintMatchDocumentResult(int document_id, const std::vector<std::string>& words, DocumentStatus status)
+//   :          
+void BenchmarkPrefixQueries(int document_count, const CorpusConfig& config)
 {
-    std::cout << "{ "s
-        << "document_id = "s << document_id << ", "s
-        << "status = "s << static_cast<int>(status) << ", "s
-        << "words ="s;
-    for (const std::string& word : words)
+    using Clock = std::chrono::steady_clock;
+    SyntheticCorpus corpus(config);
+    SearchServer search_server(corpus.GetStopWords());
+    for (int document_id = 0; document_id < document_count; ++document_id)
     {
-        std::cout << ' ' << word;
+        search_server.AddDocument(document_id, corpus.NextDocument(), DocumentStatus::ACTUAL, { document_id % 10 });
     }
-    std::cout << "}"s << std::endl;
+
+    size_t found_count = 0;
+    std::vector<double> find_latencies;
+    find_latencies.reserve(config.query_count);
+    for (int i = 0; i < config.query_count; ++i)
+    {
+        std::string query = corpus.NextQuery();
+        const size_t last_word = query.rfind(' ') + 1;
+        query.resize(std::min(query.size(), last_word + 2));
+        if (query[last_word] == '-')
+        {
+            query.erase(last_word, 1);
+        }
+        query += '*';
+        const auto start = Clock::now();
+        found_count += search_server.FindTopDocuments(query).size();
+        find_latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    std::cout << "  prefix queries: found "s << found_count << std::endl;
+    PrintLatencies("  FindTopDocuments"s, ComputePercentiles(std::move(find_latencies)));
 }
 
-void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status,
-    const std::vector<int>& ratings)
+//   :      .   
+//        
+void BenchmarkFuzzyQueries(int document_count, const CorpusConfig& config)
 {
-    try 
+    using Clock = std::chrono::steady_clock;
+    SyntheticCorpus corpus(config);
+    SearchServer search_server(corpus.GetStopWords());
+    for (int document_id = 0; document_id < document_count; ++document_id)
     {
-        search_server.AddDocument(document_id, document, status, ratings);
+        search_server.AddDocument(document_id, corpus.NextDocument(), DocumentStatus::ACTUAL, { document_id % 10 });
     }
-    catch (const std::exception& e)
+    std::vector<std::string> queries;
+    queries.reserve(config.query_count);
+    for (int i = 0; i < config.query_count; ++i)
     {
-        std::cerr << "   "s << document_id << ": "s << e.what() << std::endl;
+        std::string query = corpus.NextQuery();
+        const size_t last_word = query.find_first_not_of('-', query.rfind(' ') + 1);
+        const size_t position = std::uniform_int_distribution<size_t>(last_word, query.size() - 1)(corpus.GetGenerator());
+        query[position] = static_cast<char>('a' + std::uniform_int_distribution<int>(0, 25)(corpus.GetGenerator()));
+        queries.push_back(std::move(query));
+    }
+
+    size_t exact_found_count = 0;
+    for (const std::string& query : queries)
+    {
+        exact_found_count += search_server.FindTopDocuments(query).size();
     }
+    const size_t dictionary_bytes = search_server.GetMemoryStats().dictionary;
+    search_server.SetFuzzyMatching(2);
+    size_t found_count = 0;
+    std::vector<double> find_latencies;
+    find_latencies.reserve(queries.size());
+    for (const std::string& query : queries)
+    {
+        const auto start = Clock::now();
+        found_count += search_server.FindTopDocuments(query).size();
+        find_latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    std::cout << "  queries with typos, distance 2: found "s << found_count << " (exact "s << exact_found_count
+        << "), dictionary bytes "s << search_server.GetMemoryStats().dictionary << " (exact "s << dictionary_bytes << ")"s << std::endl;
+    PrintLatencies("  FindTopDocuments"s, ComputePercentiles(std::move(find_latencies)));
 }
 
-void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query) 
+//       :     ,
+//      BenchmarkCorpus
+void BenchmarkNormalizedCorpus(int document_count, const CorpusConfig& config)
 {
-    std::cout << "   : "s << raw_query << std::endl;
-    try
+    using Clock = std::chrono::steady_clock;
+    SyntheticCorpus corpus(config);
+    SearchServer search_server(corpus.GetStopWords());
+    //  ,       
+    std::mt19937 generator(config.seed);
+    std::bernoulli_distribution is_capitalized(0.2);
+    std::bernoulli_distribution has_punctuation(0.1);
+    Clock::duration add_time{};
+    size_t text_size = 0;
+    for (int document_id = 0; document_id < document_count; ++document_id)
     {
-        for (const Document& document : search_server.FindTopDocuments(raw_query))
+        std::string document;
+        for (const std::string& word : SplitIntoWords(corpus.NextDocument()))
         {
-            PrintDocument(document);
+            document += document.empty() ? ""s : " "s;
+            document += word;
+            if (is_capitalized(generator))
+            {
+                document[document.size() - word.size()] -= 'a' - 'A';
+            }
+            if (has_punctuation(generator))
+            {
+                document += ',';
+            }
         }
+        text_size += document.size();
+        const auto start = Clock::now();
+        search_server.AddDocument(document_id, document, DocumentStatus::ACTUAL, { document_id % 10 });
+        add_time += Clock::now() - start;
     }
-    catch (const std::exception& e) 
+    const double add_seconds = std::chrono::duration<double>(add_time).count();
+    std::cout << "  mixed case and punctuation: AddDocument "s << document_count / add_seconds << " docs/s, "s
+        << text_size / add_seconds / 1e6 << " MB/s, dictionary = "s << search_server.GetMemoryStats().dictionary << std::endl;
+}
+
+//      ,   :    
+//  ,   
+void BenchmarkImpactOrderedCorpus(int document_count, const CorpusConfig& config)
+{
+    using Clock = std::chrono::steady_clock;
+    SyntheticCorpus corpus(config);
+    SearchServer search_server(corpus.GetStopWords(), PostingLayout::IMPACT_ORDERED);
+    for (int document_id = 0; document_id < document_count; ++document_id)
     {
-        std::cerr << " : "s << e.what() << std::endl;
+        search_server.AddDocument(document_id, corpus.NextDocument(), DocumentStatus::ACTUAL, { document_id % 10 });
     }
+
+    QueryControl control;
+    control.postings_budget = 1000;
+    size_t exact_count = 0;
+    size_t recalled_count = 0;
+    int exhaustive_count = 0;
+    std::vector<double> find_latencies;
+    find_latencies.reserve(config.query_count);
+    for (int i = 0; i < config.query_count; ++i)
+    {
+        const std::string query = corpus.NextQuery();
+        const auto start = Clock::now();
+        const SearchResult result = search_server.TryFindTopDocuments(query, DocumentStatusIs{ DocumentStatus::ACTUAL }, control).GetValue();
+        find_latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        exhaustive_count += result.exhaustive ? 1 : 0;
+
+        const std::vector<Document> exact = search_server.FindTopDocuments(query);
+        exact_count += exact.size();
+        for (const Document& document : exact)
+        {
+            recalled_count += std::count_if(result.documents.begin(), result.documents.end(), [&document](const Document& found)
+                {
+                    return found.id == document.id;
+                });
+        }
+    }
+    std::cout << "  impact ordered, budget "s << control.postings_budget << " postings: exhaustive "s
+        << exhaustive_count << " of "s << config.query_count << ", recall "s
+        << (exact_count == 0 ? 1.0 : recalled_count * 1.0 / exact_count) << std::endl;
+    PrintLatencies("  FindTopDocuments"s, ComputePercentiles(std::move(find_latencies)));
 }
 
-void MatchDocuments(const SearchServer& search_server, const std::string& query)
+//  FindTopDocuments           
+void BenchmarkShardedCorpus(int document_count, const CorpusConfig& config)
 {
-    try
+    using Clock = std::chrono::steady_clock;
+    const size_t max_shard_count = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t shard_count = 1; shard_count <= std::min<size_t>(8, max_shard_count); shard_count *= 2)
     {
-        std::cout << "   : "s << query << std::endl;
-        const int document_count = search_server.GetDocumentCount();
-        for (int index = 0; index < document_count; ++index)
+        SyntheticCorpus corpus(config);
+        ShardedSearchServer search_server(corpus.GetStopWords(), shard_count);
+        for (int document_id = 0; document_id < document_count; ++document_id)
         {
-            const int document_id = search_server.GetDocumentId(index);
-            const auto [words, status] = search_server.MatchDocument(query, document_id);
-            PrintMatchDocumentResult(document_id, words, status);
+            search_server.AddDocument(document_id, corpus.NextDocument(), DocumentStatus::ACTUAL, { document_id % 10 });
+        }
+
+        size_t found_count = 0;
+        std::vector<std::string> queries;
+        std::vector<double> find_latencies;
+        find_latencies.reserve(config.query_count);
+        for (int i = 0; i < config.query_count; ++i)
+        {
+            queries.push_back(corpus.NextQuery());
+            const auto start = Clock::now();
+            found_count += search_server.FindTopDocuments(queries.back()).size();
+            find_latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+
+        //   :    
+        const auto start = Clock::now();
+        std::vector<std::future<Expected<SearchResult>>> results;
+        for (const std::string& query : queries)
+        {
+            results.push_back(search_server.FindTopDocumentsAsync(query));
+        }
+        for (auto& result : results)
+        {
+            found_count += TakeDocuments(result.get()).GetValue().size();
         }
+        const double async_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << "  shards = "s << shard_count << " (found "s << found_count << ")"s << std::endl;
+        PrintLatencies("  FindTopDocuments"s, ComputePercentiles(std::move(find_latencies)));
+        std::cout << "    FindTopDocumentsAsync: "s << queries.size() / async_seconds << " queries/s"s << std::endl;
     }
-    catch (const std::exception& e)
+}
+
+void RunSearchBenchmarks()
+{
+    const CorpusConfig config;
+    for (int document_count = 1000; document_count <= SEARCH_BENCHMARK_MAX_DOCUMENTS; document_count *= 10)
     {
-        std::cerr << "     "s << query << ": "s << e.what() << std::endl;
+        BenchmarkCorpus(document_count, config);
+        BenchmarkRanker<Bm25Ranker>("BM25"s, document_count, config);
+        BenchmarkPrefixQueries(document_count, config);
+        BenchmarkFuzzyQueries(document_count, config);
+        BenchmarkNormalizedCorpus(document_count, config);
+        BenchmarkImpactOrderedCorpus(document_count, config);
+        BenchmarkShardedCorpus(document_count, config);
     }
 }
+#endif
 
 int main() {
+#ifdef SEARCH_SERVER_TESTS
+    TestSearchServer();
+    std::cout << "Search server testing finished"s << std::endl;
+#endif
+
     setlocale(LC_ALL, "Russian");
-    SearchServer search_server("  "s);
+    SearchServer search_server("  "s, PostingLayout::DOCUMENT_ORDERED, TfIdfRanker(), TextEncoding::CP1251);
 
     AddDocument(search_server, 1, "   "s, DocumentStatus::ACTUAL, { 7, 2, 7 });
     AddDocument(search_server, 1, "    "s, DocumentStatus::ACTUAL, { 1, 2 });
@@ -473,4 +5712,13 @@ int main() {
     MatchDocuments(search_server, " -"s);
     MatchDocuments(search_server, " --"s);
     MatchDocuments(search_server, " - "s);
+
+#ifdef SEARCH_SERVER_TRACING
+    search_server.GetQueryStatistics().PrintHistograms(std::cout);
+    search_server.GetQueryStatistics().PrintSlowQueries(std::cout);
+#endif
+
+#ifdef SEARCH_BENCHMARK
+    RunSearchBenchmarks();
+#endif
 }
\ No newline at end of file
@@ -1,18 +1,157 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdlib>
 #include <string>
 #include <utility>
 #include <iterator>
 #include <cstddef>
 #include <iostream>
+#include <forward_list>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<compare>)
+#include <compare>
+#endif
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#if defined(__has_cpp_attribute)
+#if __has_cpp_attribute(no_unique_address)
+#define LIST_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+#endif
+#ifndef LIST_NO_UNIQUE_ADDRESS
+#define LIST_NO_UNIQUE_ADDRESS
+#endif
+
+//     :      ,    .
+//  operator new  operator delete     
+size_t g_allocation_count = 0;
+size_t g_allocated_bytes = 0;
+
+void* operator new(size_t size)
+{
+    ++g_allocation_count;
+    g_allocated_bytes += size;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
 
+//  :     malloc  free. GCC  
+//  free   new-       delete
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
 
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
 
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
 
+//    ,   -.
+//       ,    
+template <typename Node, size_t Capacity>
+class InlineNodePool
+{
+public:
+    InlineNodePool() = default;
+    InlineNodePool(const InlineNodePool&) = delete;
+    InlineNodePool& operator=(const InlineNodePool&) = delete;
 
-template <typename Type>
+    //     nullptr,    
+    [[nodiscard]] void* Allocate() noexcept
+    {
+        if (free_slot_ != nullptr)
+        {
+            return std::exchange(free_slot_, free_slot_->next);
+        }
+        if (used_ < Capacity)
+        {
+            return buffer_ + sizeof(Node) * used_++;
+        }
+        return nullptr;
+    }
+
+    void Deallocate(void* slot) noexcept
+    {
+        assert(Owns(slot));
+        free_slot_ = new (slot) FreeSlot{ free_slot_ };
+    }
+
+    // ,     
+    [[nodiscard]] bool Owns(const void* ptr) const noexcept
+    {
+        const std::less<const void*> less;
+        return !less(ptr, buffer_) && less(ptr, buffer_ + sizeof(buffer_));
+    }
+
+private:
+    struct FreeSlot
+    {
+        FreeSlot* next;
+    };
+    static_assert(sizeof(FreeSlot) <= sizeof(Node) && alignof(FreeSlot) <= alignof(Node));
+
+    alignas(Node) unsigned char buffer_[sizeof(Node) * Capacity];
+    FreeSlot* free_slot_ = nullptr;
+    size_t used_ = 0;
+};
+
+//   :      
+template <typename Node>
+class InlineNodePool<Node, 0>
+{
+public:
+    [[nodiscard]] void* Allocate() noexcept
+    {
+        return nullptr;
+    }
+
+    void Deallocate(void*) noexcept
+    {
+        assert(false);
+    }
+
+    [[nodiscard]] bool Owns(const void*) const noexcept
+    {
+        return false;
+    }
+};
+
+// InlineCapacity -  ,      .
+//     InlineCapacity,      
+template <typename Type, size_t InlineCapacity = 0>
 class SingleLinkedList
 {
+    struct NodeBlock;
+
     struct Node
     {
         Node() = default;
@@ -20,8 +159,14 @@ class SingleLinkedList
             : value(val)
             , next_node(next)
         { }
+        Node(Type&& val, Node* next)
+            : value(std::move(val))
+            , next_node(next)
+        { }
         Type value = Type();
         Node* next_node = nullptr;
+        // ,   Compact  ,  nullptr
+        NodeBlock* block = nullptr;
     };   
 
         //    .
@@ -145,23 +290,40 @@ public:
 
     SingleLinkedList() = default;
 
-    SingleLinkedList(std::initializer_list<Type> values) 
+    SingleLinkedList(std::initializer_list<Type> values)
+        : SingleLinkedList(values.begin(), values.end())
+    { }
+
+    //      [first, last)   .
+    //       ,   ,   
+    //   ,     
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    SingleLinkedList(InputIt first, InputIt last)
     {
-        for (const auto& temp : values)
-        {
-            PushBack(temp);
-        }        
+        const Chain chain = MakeChain(first, last);
+        head_.next_node = chain.first;
+        size_ = chain.size;
     }
 
     SingleLinkedList(const SingleLinkedList& other)
+        : SingleLinkedList(other.begin(), other.end())
+    { }
+
+    //   other   .       ,
+    //     other      
+    SingleLinkedList(SingleLinkedList&& other) noexcept(InlineCapacity == 0 || std::is_nothrow_move_constructible_v<Type>)
     {
-        assert(size_ == 0 && head_.next_node == nullptr);
-        SingleLinkedList temp;        
-        for (auto it = other.begin(); it != other.end(); ++it)
+        TakeNodes(other);
+    }
+
+    SingleLinkedList& operator=(SingleLinkedList&& rhs) noexcept(InlineCapacity == 0 || std::is_nothrow_move_constructible_v<Type>)
+    {
+        if (this != &rhs)
         {
-            temp.PushBack(*it);
-        }        
-        swap(temp);
+            Clear();
+            TakeNodes(rhs);
+        }
+        return *this;
     }
 
     SingleLinkedList& operator=(const SingleLinkedList& rhs) 
@@ -174,13 +336,28 @@ public:
         return *this;
     }
 
-    //      O(1)
-    void swap(SingleLinkedList& other) noexcept 
+    //      O(1).
+    //       ,    ,
+    //     O(InlineCapacity)       
+    void swap(SingleLinkedList& other) noexcept(InlineCapacity == 0 || std::is_nothrow_move_constructible_v<Type>)
     {
-        Node* temp_head = other.head_.next_node;
-        other.head_.next_node = head_.next_node;
-        head_.next_node = temp_head;
-        std::swap(size_, other.size_);
+        if constexpr (InlineCapacity == 0)
+        {
+            Node* temp_head = other.head_.next_node;
+            other.head_.next_node = head_.next_node;
+            head_.next_node = temp_head;
+            std::swap(size_, other.size_);
+        }
+        else
+        {
+            if (this == &other)
+            {
+                return;
+            }
+            SingleLinkedList temp(std::move(other));
+            other.TakeNodes(*this);
+            TakeNodes(temp);
+        }
     }
 
     ~SingleLinkedList()
@@ -274,13 +451,34 @@ public:
         }  
         
         Node* next_node = pos.node_->next_node;
-        Node* new_node = new Node(value, next_node);
+        Node* new_node = CreateNode(value, next_node);
         pos.node_->next_node = new_node;
         ++size_;
 
         return Iterator{ new_node };
     }  
         
+    //    [first, last)  pos       
+    // (  pos,   ).         ,
+    //         ( )
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    Iterator InsertAfter(ConstIterator pos, InputIt first, InputIt last)
+    {
+        assert(pos != end());
+
+        const Chain chain = MakeChain(first, last);
+        if (chain.first == nullptr)
+        {
+            return Iterator{ pos.node_ };
+        }
+
+        chain.last->next_node = pos.node_->next_node;
+        pos.node_->next_node = chain.first;
+        size_ += chain.size;
+
+        return Iterator{ chain.last };
+    }
+
     Iterator EraseAfter(ConstIterator pos) noexcept 
     {
         assert(pos != end());
@@ -288,243 +486,1040 @@ public:
         Node* node_to_erase = pos.node_->next_node;
         Node* temp = node_to_erase->next_node;
         pos.node_->next_node = temp;       
-        delete node_to_erase;
+        DestroyNode(node_to_erase);
         size_--;
 
         return Iterator{ temp };
     }
 
-    private:
-        Node head_;
-        size_t size_ = 0;
-        Iterator before_begin_{ &head_ };
-};
-
-template <typename Type>
-void SingleLinkedList<Type>::PopFront() noexcept
-{  
-    assert(!IsEmpty());
-    Node* temp = head_.next_node;
-    head_.next_node = temp->next_node;
-    delete temp;
-    size_--;
-}
-
-template <typename Type>
-void SingleLinkedList<Type>::Clear() noexcept
-{   
-    while (head_.next_node != nullptr)
-    {
-        Node* temp = head_.next_node;
-        head_.next_node = temp->next_node;
-        delete temp;
-        size_--;
-    }
-}
-
-template <typename Type>
-void SingleLinkedList<Type>::PushBack(const Type& value)
-{
-    Node* temp = &head_;
-    while (temp->next_node != nullptr)
+    //     other    pos,     .
+    //    other .  - O(other.GetSize()):     other.
+    //     other     
+    void SpliceAfter(ConstIterator pos, SingleLinkedList& other) noexcept(InlineCapacity == 0)
     {
-        temp = temp->next_node;
-    }
-    temp->next_node = new Node(value, nullptr);
-    ++size_;
-}
-
-template <typename Type>
-void SingleLinkedList<Type>::PushFront(const Type& value)
-{
-    head_.next_node = new Node(value, head_.next_node);
-    ++size_;
-}
+        assert(pos != end());
 
-template <typename Type>
-void swap(SingleLinkedList<Type>& lhs, SingleLinkedList<Type>& rhs) noexcept 
-{
-    lhs.swap(rhs);
-}
+        if (this == &other || other.IsEmpty())
+        {
+            return;
+        }
+        AdoptInlineNodes(other, &other.head_, nullptr);
 
-template <typename Type>
-bool operator==(const SingleLinkedList<Type>& lhs, const SingleLinkedList<Type>& rhs)
-{   
-    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
-}
+        Node* other_last = other.head_.next_node;
+        while (other_last->next_node != nullptr)
+        {
+            other_last = other_last->next_node;
+        }
+        other_last->next_node = pos.node_->next_node;
+        pos.node_->next_node = other.head_.next_node;
+        other.head_.next_node = nullptr;
 
-template <typename Type>
-bool operator!=(const SingleLinkedList<Type>& lhs, const SingleLinkedList<Type>& rhs) 
-{    
-    return !std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
-}
+        size_ += other.size_;
+        other.size_ = 0;
+    }
 
-template <typename Type>
-bool operator<(const SingleLinkedList<Type>& lhs, const SingleLinkedList<Type>& rhs)
-{    
-    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
-}
+    //     (first, last)  other    pos.
+    //  pos      .
+    //  - O( ):        .
+    //    Compact   ,       
+    void SpliceAfter(ConstIterator pos, SingleLinkedList& other, ConstIterator first, ConstIterator last) noexcept(InlineCapacity == 0)
+    {
+        assert(pos != end() && first != end());
 
-template <typename Type>
-bool operator<=(const SingleLinkedList<Type>& lhs, const SingleLinkedList<Type>& rhs) 
-{
-    
-    return !std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()) 
-        || std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
-}
+        if (first.node_->next_node == last.node_ || pos == first)
+        {
+            return;
+        }
+        AdoptInlineNodes(other, first.node_, last.node_);
 
-template <typename Type>
-bool operator>(const SingleLinkedList<Type>& lhs, const SingleLinkedList<Type>& rhs) 
-{
-    
-    return !std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
-}
+        Node* range_first = first.node_->next_node;
+        size_t range_size = 1;
+        Node* range_last = range_first;
+        while (range_last->next_node != last.node_)
+        {
+            range_last = range_last->next_node;
+            ++range_size;
+        }
 
-template <typename Type>
-bool operator>=(const SingleLinkedList<Type>& lhs, const SingleLinkedList<Type>& rhs)
-{
-    return !std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end())
-        || std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
-}
+        first.node_->next_node = last.node_;
+        range_last->next_node = pos.node_->next_node;
+        pos.node_->next_node = range_first;
 
+        if (this != &other)
+        {
+            size_ += range_size;
+            other.size_ -= range_size;
+        }
+    }
 
+    //    other      O(n + m).
+    //     , other  .
+    //  :        .
+    //  comp  ,      ,    
+    template <typename Compare>
+    void Merge(SingleLinkedList& other, Compare comp)
+    {
+        if (this == &other)
+        {
+            return;
+        }
+        AdoptInlineNodes(other, &other.head_, nullptr);
 
+        Node* other_first = other.head_.next_node;
+        other.head_.next_node = nullptr;
+        size_ += other.size_;
+        other.size_ = 0;
+        MergeChains(head_.next_node, other_first, comp);
+    }
 
+    void Merge(SingleLinkedList& other)
+    {
+        Merge(other, std::less<Type>());
+    }
 
-void Test1() {
-    // ,    
-    struct DeletionSpy
+    //       O(n log n)      .
+    //  comp  ,    ,    
+    template <typename Compare>
+    void Sort(Compare comp)
     {
-        DeletionSpy() = default;
-        explicit DeletionSpy(int& instance_counter) noexcept
-            : instance_counter_ptr_(&instance_counter)  //
+        if (size_ < 2)
         {
-            OnAddInstance();
+            return;
         }
-        DeletionSpy(const DeletionSpy& other) noexcept
-            : instance_counter_ptr_(other.instance_counter_ptr_)  //
+
+        //  runs[i]     2^i   nullptr
+        Node* runs[std::numeric_limits<size_t>::digits] = {};
+        Node* rest = head_.next_node;
+        Node* run = nullptr;
+        head_.next_node = nullptr;
+
+        try
         {
-            OnAddInstance();
-        }
-        DeletionSpy& operator=(const DeletionSpy& rhs) noexcept {
-            if (this != &rhs) {
-                auto rhs_copy(rhs);
-                std::swap(instance_counter_ptr_, rhs_copy.instance_counter_ptr_);
+            while (rest != nullptr)
+            {
+                run = rest;
+                rest = rest->next_node;
+                run->next_node = nullptr;
+
+                size_t rank = 0;
+                for (; runs[rank] != nullptr; ++rank)
+                {
+                    //   runs[rank]     ,    
+                    MergeChains(runs[rank], std::exchange(run, nullptr), comp);
+                    run = std::exchange(runs[rank], nullptr);
+                }
+                runs[rank] = std::exchange(run, nullptr);
             }
-            return *this;
-        }
-        ~DeletionSpy() {
-            OnDeleteInstance();
-        }
 
-    private:
-        void OnAddInstance() noexcept 
-        {
-            if (instance_counter_ptr_)
+            for (Node*& chain : runs)
             {
-                ++(*instance_counter_ptr_);
+                if (chain != nullptr)
+                {
+                    MergeChains(chain, std::exchange(head_.next_node, nullptr), comp);
+                    head_.next_node = std::exchange(chain, nullptr);
+                }
             }
         }
-        void OnDeleteInstance() noexcept
+        catch (...)
         {
-            if (instance_counter_ptr_)
+            //    ,      
+            head_.next_node = ConcatChains(head_.next_node, ConcatChains(run, rest));
+            for (Node* chain : runs)
             {
-                assert(*instance_counter_ptr_ != 0);
-                --(*instance_counter_ptr_);
+                head_.next_node = ConcatChains(chain, head_.next_node);
             }
+            throw;
         }
+    }
 
-        int* instance_counter_ptr_ = nullptr;
-    };
-
-    //    
+    void Sort()
     {
-        SingleLinkedList<int> l;
-        assert(l.IsEmpty());
-        assert(l.GetSize() == 0u);
-
-        l.PushFront(0);
-        l.PushFront(1);
-        assert(l.GetSize() == 2);
-        assert(!l.IsEmpty());
-
-        l.Clear();
-        assert(l.GetSize() == 0);
-        assert(l.IsEmpty());
+        Sort(std::less<Type>());
     }
 
-    //    
+    //  fn    .  fn   ,
+    //      . fn     
+    template <typename Function>
+    void ForEach(Function fn)
     {
-        int item0_counter = 0;
-        int item1_counter = 0;
-        int item2_counter = 0;
-        {
-            SingleLinkedList<DeletionSpy> list;
-            list.PushFront(DeletionSpy{ item0_counter });
-            list.PushFront(DeletionSpy{ item1_counter });
-            list.PushFront(DeletionSpy{ item2_counter });
+        ForEachNode(head_.next_node, fn);
+    }
 
-            assert(item0_counter == 1);
-            assert(item1_counter == 1);
-            assert(item2_counter == 1);
-            list.Clear();
-            assert(item0_counter == 0);
-            assert(item1_counter == 0);
-            assert(item2_counter == 0);
+    template <typename Function>
+    void ForEach(Function fn) const
+    {
+        ForEachNode(head_.next_node, fn);
+    }
 
-            list.PushFront(DeletionSpy{ item0_counter });
-            list.PushFront(DeletionSpy{ item1_counter });
-            list.PushFront(DeletionSpy{ item2_counter });
-            assert(item0_counter == 1);
-            assert(item1_counter == 1);
-            assert(item2_counter == 1);
-        }
-        assert(item0_counter == 0);
-        assert(item1_counter == 0);
-        assert(item2_counter == 0);
+    //  fn    ,     batch_size  .
+    //            .
+    // fn     
+    template <typename Function>
+    void ForEachBatch(Function fn, size_t batch_size)
+    {
+        ForEachNodeBatch(head_.next_node, fn, batch_size);
     }
 
-    //  ,     N-
-    struct ThrowOnCopy 
+    template <typename Function>
+    void ForEachBatch(Function fn, size_t batch_size) const
     {
-        ThrowOnCopy() = default;
-        explicit ThrowOnCopy(int& copy_counter) noexcept
-            : countdown_ptr(&copy_counter) 
-        {}
+        ForEachNodeBatch(head_.next_node, fn, batch_size);
+    }
 
-        ThrowOnCopy(const ThrowOnCopy& other)
-            : countdown_ptr(other.countdown_ptr)  //
+    //            ,   
+    //    .     ,       .
+    //  ,      ,  .
+    //          .       ,
+    //  ,     .      
+    void Compact()
+    {
+        size_t heap_node_count = 0;
+        NodeBlock* first_block = nullptr;
+        bool is_compact = true;
+        for (Node* node = head_.next_node; node != nullptr; node = node->next_node)
         {
-            if (countdown_ptr) 
+            if (!inline_nodes_.Owns(node))
             {
-                if (*countdown_ptr == 0)
+                if (heap_node_count == 0)
                 {
-                    throw std::bad_alloc();
+                    first_block = node->block;
                 }
-                else 
+                is_compact = is_compact && first_block != nullptr && node == first_block->nodes + heap_node_count;
+                ++heap_node_count;
+            }
+        }
+        if (heap_node_count < 2 || is_compact)
+        {
+            return;
+        }
+
+        NodeBlock* block = AllocateBlock(heap_node_count);
+        size_t constructed = 0;
+        try
+        {
+            for (Node* node = head_.next_node; node != nullptr; node = node->next_node)
+            {
+                if (!inline_nodes_.Owns(node))
                 {
-                    --(*countdown_ptr);
+                    new (block->nodes + constructed) Node(std::move_if_noexcept(node->value), nullptr);
+                    block->nodes[constructed++].block = block;
                 }
             }
         }
-        //      
-        ThrowOnCopy& operator=(const ThrowOnCopy& rhs) = delete;
-        //    .    nullptr,     .
-        //   ,    
-        int* countdown_ptr = nullptr;
-    };
-
-    {
-        bool exception_was_thrown = false;
-        //      ,     
-        for (int max_copy_counter = 5; max_copy_counter >= 0; --max_copy_counter) 
+        catch (...)
         {
-            //   
-            SingleLinkedList<ThrowOnCopy> list;
-            list.PushFront(ThrowOnCopy{});
-            try 
+            while (constructed > 0)
             {
-                int copy_counter = max_copy_counter;
+                block->nodes[--constructed].~Node();
+            }
+            FreeBlock(block);
+            throw;
+        }
+        block->live_nodes.store(constructed, std::memory_order_relaxed);
+
+        Node* replacement = block->nodes;
+        Node* prev = &head_;
+        while (prev->next_node != nullptr)
+        {
+            Node* node = prev->next_node;
+            if (!inline_nodes_.Owns(node))
+            {
+                replacement->next_node = node->next_node;
+                prev->next_node = replacement;
+                DestroyNode(node);
+                node = replacement++;
+            }
+            prev = node;
+        }
+    }
+
+    private:
+        //     ForEachBatch
+        static constexpr size_t MAX_BATCH_SIZE = 64;
+
+        static void PrefetchNode(const Node* node) noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(node);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_prefetch(reinterpret_cast<const char*>(node), _MM_HINT_T0);
+#else
+            (void)node;
+#endif
+        }
+
+        template <typename Function>
+        static void ForEachNode(Node* node, Function& fn)
+        {
+            while (node != nullptr)
+            {
+                Node* next = node->next_node;
+                if (next != nullptr)
+                {
+                    PrefetchNode(next);
+                }
+                fn(node->value);
+                node = next;
+            }
+        }
+
+        template <typename Function>
+        static void ForEachNodeBatch(Node* node, Function& fn, size_t distance)
+        {
+            distance = std::clamp<size_t>(distance, 1, MAX_BATCH_SIZE);
+            // ahead     distance 
+            Node* ahead = node;
+            for (size_t i = 0; ahead != nullptr && i < distance; ++i)
+            {
+                PrefetchNode(ahead);
+                ahead = ahead->next_node;
+            }
+            while (node != nullptr)
+            {
+                if (ahead != nullptr)
+                {
+                    PrefetchNode(ahead);
+                    ahead = ahead->next_node;
+                }
+                Node* next = node->next_node;
+                fn(node->value);
+                node = next;
+            }
+        }
+
+        //     ,    ,    
+        template <typename... Args>
+        Node* CreateNode(Args&&... args)
+        {
+            if (void* slot = inline_nodes_.Allocate())
+            {
+                try
+                {
+                    return new (slot) Node(std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    inline_nodes_.Deallocate(slot);
+                    throw;
+                }
+            }
+            return new Node(std::forward<Args>(args)...);
+        }
+
+        void DestroyNode(Node* node) noexcept
+        {
+            if (inline_nodes_.Owns(node))
+            {
+                node->~Node();
+                inline_nodes_.Deallocate(node);
+            }
+            else if (NodeBlock* block = node->block)
+            {
+                node->~Node();
+                ReleaseBlockNode(block);
+            }
+            else
+            {
+                delete node;
+            }
+        }
+
+        //  ,   Compact   .       ,
+        //             
+        struct NodeBlock
+        {
+            Node* nodes = nullptr;
+            size_t capacity = 0;
+            std::atomic<size_t> live_nodes{ 0 };
+        };
+
+        static NodeBlock* AllocateBlock(size_t capacity)
+        {
+            NodeBlock* block = new NodeBlock;
+            try
+            {
+                block->nodes = std::allocator<Node>().allocate(capacity);
+            }
+            catch (...)
+            {
+                delete block;
+                throw;
+            }
+            block->capacity = capacity;
+            return block;
+        }
+
+        static void FreeBlock(NodeBlock* block) noexcept
+        {
+            std::allocator<Node>().deallocate(block->nodes, block->capacity);
+            delete block;
+        }
+
+        //            
+        static void ReleaseBlockNode(NodeBlock* block) noexcept
+        {
+            if (block->live_nodes.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                FreeBlock(block);
+            }
+        }
+
+        //    other    ,   .
+        //     ,    other
+        void TakeNodes(SingleLinkedList& other) noexcept(InlineCapacity == 0 || std::is_nothrow_move_constructible_v<Type>)
+        {
+            assert(IsEmpty());
+            if constexpr (InlineCapacity == 0)
+            {
+                head_.next_node = std::exchange(other.head_.next_node, nullptr);
+                size_ = std::exchange(other.size_, 0);
+            }
+            else
+            {
+                Node** tail = &head_.next_node;
+                while (other.head_.next_node != nullptr)
+                {
+                    Node* node = other.head_.next_node;
+                    if (other.inline_nodes_.Owns(node))
+                    {
+                        *tail = CreateNode(std::move(node->value), nullptr);
+                        other.head_.next_node = node->next_node;
+                        other.DestroyNode(node);
+                    }
+                    else
+                    {
+                        other.head_.next_node = node->next_node;
+                        node->next_node = nullptr;
+                        *tail = node;
+                    }
+                    tail = &(*tail)->next_node;
+                    --other.size_;
+                    ++size_;
+                }
+            }
+        }
+
+        //     prev  stop,     other,   ,
+        //      .     
+        void AdoptInlineNodes(SingleLinkedList& other, Node* prev, Node* stop)
+        {
+            if constexpr (InlineCapacity > 0)
+            {
+                if (this == &other)
+                {
+                    return;
+                }
+                while (prev->next_node != stop)
+                {
+                    Node* node = prev->next_node;
+                    if (other.inline_nodes_.Owns(node))
+                    {
+                        Node* replacement = CreateNode(std::move_if_noexcept(node->value), node->next_node);
+                        prev->next_node = replacement;
+                        other.DestroyNode(node);
+                        node = replacement;
+                    }
+                    prev = node;
+                }
+            }
+        }
+
+        //  ,     
+        struct Chain
+        {
+            Node* first = nullptr;
+            Node* last = nullptr;
+            size_t size = 0;
+        };
+
+        //      [first, last)   .
+        //      ,    
+        template <typename InputIt>
+        Chain MakeChain(InputIt first, InputIt last)
+        {
+            Chain chain;
+            try
+            {
+                Node** tail = &chain.first;
+                for (; first != last; ++first)
+                {
+                    chain.last = CreateNode(*first, nullptr);
+                    *tail = chain.last;
+                    tail = &chain.last->next_node;
+                    ++chain.size;
+                }
+            }
+            catch (...)
+            {
+                while (chain.first != nullptr)
+                {
+                    DestroyNode(std::exchange(chain.first, chain.first->next_node));
+                }
+                throw;
+            }
+            return chain;
+        }
+
+        //    rhs    lhs,    lhs.
+        //       lhs.    comp  lhs     
+        template <typename Compare>
+        static void MergeChains(Node*& lhs, Node* rhs, Compare& comp)
+        {
+            Node* merged = nullptr;
+            Node** tail = &merged;
+            Node* left = lhs;
+            try
+            {
+                while (left != nullptr && rhs != nullptr)
+                {
+                    if (comp(rhs->value, left->value))
+                    {
+                        *tail = rhs;
+                        rhs = rhs->next_node;
+                    }
+                    else
+                    {
+                        *tail = left;
+                        left = left->next_node;
+                    }
+                    tail = &(*tail)->next_node;
+                }
+            }
+            catch (...)
+            {
+                *tail = ConcatChains(left, rhs);
+                lhs = merged;
+                throw;
+            }
+            *tail = (left != nullptr) ? left : rhs;
+            lhs = merged;
+        }
+
+        //   second    first    
+        static Node* ConcatChains(Node* first, Node* second) noexcept
+        {
+            if (first == nullptr)
+            {
+                return second;
+            }
+            Node* last = first;
+            while (last->next_node != nullptr)
+            {
+                last = last->next_node;
+            }
+            last->next_node = second;
+            return first;
+        }
+
+        Node head_;
+        size_t size_ = 0;
+        Iterator before_begin_{ &head_ };
+        LIST_NO_UNIQUE_ADDRESS InlineNodePool<Node, InlineCapacity> inline_nodes_;
+};
+
+template <typename Type, size_t InlineCapacity>
+void SingleLinkedList<Type, InlineCapacity>::PopFront() noexcept
+{  
+    assert(!IsEmpty());
+    Node* temp = head_.next_node;
+    head_.next_node = temp->next_node;
+    DestroyNode(temp);
+    size_--;
+}
+
+template <typename Type, size_t InlineCapacity>
+void SingleLinkedList<Type, InlineCapacity>::Clear() noexcept
+{   
+    while (head_.next_node != nullptr)
+    {
+        Node* temp = head_.next_node;
+        head_.next_node = temp->next_node;
+        DestroyNode(temp);
+        size_--;
+    }
+}
+
+template <typename Type, size_t InlineCapacity>
+void SingleLinkedList<Type, InlineCapacity>::PushBack(const Type& value)
+{
+    Node* temp = &head_;
+    while (temp->next_node != nullptr)
+    {
+        temp = temp->next_node;
+    }
+    temp->next_node = CreateNode(value, nullptr);
+    ++size_;
+}
+
+template <typename Type, size_t InlineCapacity>
+void SingleLinkedList<Type, InlineCapacity>::PushFront(const Type& value)
+{
+    head_.next_node = CreateNode(value, head_.next_node);
+    ++size_;
+}
+
+template <typename Type, size_t InlineCapacity>
+void swap(SingleLinkedList<Type, InlineCapacity>& lhs, SingleLinkedList<Type, InlineCapacity>& rhs) noexcept(noexcept(lhs.swap(rhs)))
+{
+    lhs.swap(rhs);
+}
+
+//     ,   ,    
+template <typename Type, size_t InlineCapacity>
+bool operator==(const SingleLinkedList<Type, InlineCapacity>& lhs, const SingleLinkedList<Type, InlineCapacity>& rhs)
+{   
+    return lhs.GetSize() == rhs.GetSize() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Type, size_t InlineCapacity>
+bool operator!=(const SingleLinkedList<Type, InlineCapacity>& lhs, const SingleLinkedList<Type, InlineCapacity>& rhs) 
+{    
+    return !(lhs == rhs);
+}
+
+//      operator<,      
+template <typename Type, size_t InlineCapacity>
+bool operator<(const SingleLinkedList<Type, InlineCapacity>& lhs, const SingleLinkedList<Type, InlineCapacity>& rhs)
+{    
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Type, size_t InlineCapacity>
+bool operator<=(const SingleLinkedList<Type, InlineCapacity>& lhs, const SingleLinkedList<Type, InlineCapacity>& rhs) 
+{
+    return !(rhs < lhs);
+}
+
+template <typename Type, size_t InlineCapacity>
+bool operator>(const SingleLinkedList<Type, InlineCapacity>& lhs, const SingleLinkedList<Type, InlineCapacity>& rhs) 
+{
+    return rhs < lhs;
+}
+
+template <typename Type, size_t InlineCapacity>
+bool operator>=(const SingleLinkedList<Type, InlineCapacity>& lhs, const SingleLinkedList<Type, InlineCapacity>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+#if defined(__cpp_lib_three_way_comparison)
+//       
+template <typename Type, size_t InlineCapacity>
+auto operator<=>(const SingleLinkedList<Type, InlineCapacity>& lhs, const SingleLinkedList<Type, InlineCapacity>& rhs)
+{
+    return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+#endif
+
+//     operator==:     ,
+//       std::unordered_map  std::unordered_set
+template <typename Type, size_t InlineCapacity>
+struct std::hash<SingleLinkedList<Type, InlineCapacity>>
+{
+    size_t operator()(const SingleLinkedList<Type, InlineCapacity>& list) const
+    {
+        const std::hash<Type> element_hasher;
+        size_t seed = list.GetSize();
+        list.ForEach([&seed, &element_hasher](const Type& value) {
+            seed ^= element_hasher(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            });
+        return seed;
+    }
+};
+
+//   .     ,   
+//    ,      
+struct IntrusiveListHook
+{
+    IntrusiveListHook() = default;
+
+    //       ,         
+    IntrusiveListHook(const IntrusiveListHook&) noexcept
+    { }
+
+    IntrusiveListHook& operator=(const IntrusiveListHook&) noexcept
+    {
+        return *this;
+    }
+
+    IntrusiveListHook* next_hook = nullptr;
+};
+
+//   .   :   ,   
+// (,  ),      .   
+//              
+template <typename Type>
+class IntrusiveSingleLinkedList
+{
+    static_assert(std::is_base_of_v<IntrusiveListHook, Type>,
+        "Type must inherit from IntrusiveListHook");
+
+    template <typename ValueType>
+    class BasicIterator
+    {
+        friend class IntrusiveSingleLinkedList;
+
+        explicit BasicIterator(IntrusiveListHook* hook) : hook_(hook) {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = ValueType*;
+        using reference = ValueType&;
+
+        BasicIterator() = default;
+
+        BasicIterator(const BasicIterator<Type>& other) noexcept
+        {
+            hook_ = other.hook_;
+        }
+
+        BasicIterator& operator=(const BasicIterator& rhs) = default;
+
+        [[nodiscard]] bool operator==(const BasicIterator<const Type>& rhs) const noexcept
+        {
+            return hook_ == rhs.hook_;
+        }
+
+        [[nodiscard]] bool operator!=(const BasicIterator<const Type>& rhs) const noexcept
+        {
+            return !(*this == rhs);
+        }
+
+        [[nodiscard]] bool operator==(const BasicIterator<Type>& rhs) const noexcept
+        {
+            return hook_ == rhs.hook_;
+        }
+
+        [[nodiscard]] bool operator!=(const BasicIterator<Type>& rhs) const noexcept
+        {
+            return !(*this == rhs);
+        }
+
+        BasicIterator& operator++() noexcept
+        {
+            assert(hook_ != nullptr);
+            hook_ = hook_->next_hook;
+            return *this;
+        }
+
+        BasicIterator operator++(int) noexcept
+        {
+            auto old_value(*this);
+            ++(*this);
+            return old_value;
+        }
+
+        //  before_begin   ,       
+        [[nodiscard]] reference operator*() const noexcept
+        {
+            assert(hook_ != nullptr);
+            return static_cast<reference>(*hook_);
+        }
+
+        [[nodiscard]] pointer operator->() const noexcept
+        {
+            assert(hook_ != nullptr);
+            return &static_cast<reference>(*hook_);
+        }
+
+    private:
+        IntrusiveListHook* hook_ = nullptr;
+    };
+
+public:
+    using value_type = Type;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using Iterator = BasicIterator<Type>;
+    using ConstIterator = BasicIterator<const Type>;
+
+    IntrusiveSingleLinkedList() = default;
+
+    //       ,    ,  
+    IntrusiveSingleLinkedList(const IntrusiveSingleLinkedList&) = delete;
+    IntrusiveSingleLinkedList& operator=(const IntrusiveSingleLinkedList&) = delete;
+
+    IntrusiveSingleLinkedList(IntrusiveSingleLinkedList&& other) noexcept
+    {
+        swap(other);
+    }
+
+    IntrusiveSingleLinkedList& operator=(IntrusiveSingleLinkedList&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            Clear();
+            swap(rhs);
+        }
+        return *this;
+    }
+
+    ~IntrusiveSingleLinkedList()
+    {
+        Clear();
+    }
+
+    //      O(1)
+    void swap(IntrusiveSingleLinkedList& other) noexcept
+    {
+        std::swap(head_.next_hook, other.head_.next_hook);
+        std::swap(size_, other.size_);
+    }
+
+    [[nodiscard]] size_t GetSize() const noexcept
+    {
+        return size_;
+    }
+
+    [[nodiscard]] bool IsEmpty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] Iterator begin() noexcept
+    {
+        return Iterator{ head_.next_hook };
+    }
+
+    [[nodiscard]] Iterator end() noexcept
+    {
+        return Iterator{};
+    }
+
+    [[nodiscard]] ConstIterator begin() const noexcept
+    {
+        return ConstIterator{ head_.next_hook };
+    }
+
+    [[nodiscard]] ConstIterator end() const noexcept
+    {
+        return ConstIterator{};
+    }
+
+    [[nodiscard]] ConstIterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    [[nodiscard]] ConstIterator cend() const noexcept
+    {
+        return end();
+    }
+
+    //       .   
+    [[nodiscard]] Iterator before_begin() noexcept
+    {
+        return Iterator{ &head_ };
+    }
+
+    [[nodiscard]] ConstIterator before_begin() const noexcept
+    {
+        return ConstIterator{ const_cast<IntrusiveListHook*>(&head_) };
+    }
+
+    [[nodiscard]] ConstIterator cbefore_begin() const noexcept
+    {
+        return before_begin();
+    }
+
+    //   value      O(1)   
+    void PushFront(Type& value) noexcept
+    {
+        InsertAfter(cbefore_begin(), value);
+    }
+
+    //    .    
+    void PopFront() noexcept
+    {
+        assert(!IsEmpty());
+        EraseAfter(cbefore_begin());
+    }
+
+    //   value  pos     .       
+    Iterator InsertAfter(ConstIterator pos, Type& value) noexcept
+    {
+        assert(pos != end());
+        IntrusiveListHook& hook = value;
+        assert(hook.next_hook == nullptr);
+
+        hook.next_hook = pos.hook_->next_hook;
+        pos.hook_->next_hook = &hook;
+        ++size_;
+
+        return Iterator{ &hook };
+    }
+
+    //  ,   pos,       .
+    //           
+    Iterator EraseAfter(ConstIterator pos) noexcept
+    {
+        assert(pos != end() && pos.hook_->next_hook != nullptr);
+
+        IntrusiveListHook* hook_to_erase = pos.hook_->next_hook;
+        pos.hook_->next_hook = hook_to_erase->next_hook;
+        hook_to_erase->next_hook = nullptr;
+        --size_;
+
+        return Iterator{ pos.hook_->next_hook };
+    }
+
+    //       O(n),        
+    void Clear() noexcept
+    {
+        while (head_.next_hook != nullptr)
+        {
+            EraseAfter(cbefore_begin());
+        }
+    }
+
+private:
+    IntrusiveListHook head_;
+    size_t size_ = 0;
+};
+
+template <typename Type>
+void swap(IntrusiveSingleLinkedList<Type>& lhs, IntrusiveSingleLinkedList<Type>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+
+//  ,     N-
+struct ThrowOnCopy
+{
+    ThrowOnCopy() = default;
+    explicit ThrowOnCopy(int& copy_counter) noexcept
+        : countdown_ptr(&copy_counter)
+    {}
+
+    ThrowOnCopy(const ThrowOnCopy& other)
+        : countdown_ptr(other.countdown_ptr)  //
+    {
+        if (countdown_ptr)
+        {
+            if (*countdown_ptr == 0)
+            {
+                throw std::bad_alloc();
+            }
+            else
+            {
+                --(*countdown_ptr);
+            }
+        }
+    }
+    //      
+    ThrowOnCopy& operator=(const ThrowOnCopy& rhs) = delete;
+    //    .    nullptr,     .
+    //   ,    
+    int* countdown_ptr = nullptr;
+};
+
+void Test1() {
+    // ,    
+    struct DeletionSpy
+    {
+        DeletionSpy() = default;
+        explicit DeletionSpy(int& instance_counter) noexcept
+            : instance_counter_ptr_(&instance_counter)  //
+        {
+            OnAddInstance();
+        }
+        DeletionSpy(const DeletionSpy& other) noexcept
+            : instance_counter_ptr_(other.instance_counter_ptr_)  //
+        {
+            OnAddInstance();
+        }
+        DeletionSpy& operator=(const DeletionSpy& rhs) noexcept {
+            if (this != &rhs) {
+                auto rhs_copy(rhs);
+                std::swap(instance_counter_ptr_, rhs_copy.instance_counter_ptr_);
+            }
+            return *this;
+        }
+        ~DeletionSpy() {
+            OnDeleteInstance();
+        }
+
+    private:
+        void OnAddInstance() noexcept 
+        {
+            if (instance_counter_ptr_)
+            {
+                ++(*instance_counter_ptr_);
+            }
+        }
+        void OnDeleteInstance() noexcept
+        {
+            if (instance_counter_ptr_)
+            {
+                assert(*instance_counter_ptr_ != 0);
+                --(*instance_counter_ptr_);
+            }
+        }
+
+        int* instance_counter_ptr_ = nullptr;
+    };
+
+    //    
+    {
+        SingleLinkedList<int> l;
+        assert(l.IsEmpty());
+        assert(l.GetSize() == 0u);
+
+        l.PushFront(0);
+        l.PushFront(1);
+        assert(l.GetSize() == 2);
+        assert(!l.IsEmpty());
+
+        l.Clear();
+        assert(l.GetSize() == 0);
+        assert(l.IsEmpty());
+    }
+
+    //    
+    {
+        int item0_counter = 0;
+        int item1_counter = 0;
+        int item2_counter = 0;
+        {
+            SingleLinkedList<DeletionSpy> list;
+            list.PushFront(DeletionSpy{ item0_counter });
+            list.PushFront(DeletionSpy{ item1_counter });
+            list.PushFront(DeletionSpy{ item2_counter });
+
+            assert(item0_counter == 1);
+            assert(item1_counter == 1);
+            assert(item2_counter == 1);
+            list.Clear();
+            assert(item0_counter == 0);
+            assert(item1_counter == 0);
+            assert(item2_counter == 0);
+
+            list.PushFront(DeletionSpy{ item0_counter });
+            list.PushFront(DeletionSpy{ item1_counter });
+            list.PushFront(DeletionSpy{ item2_counter });
+            assert(item0_counter == 1);
+            assert(item1_counter == 1);
+            assert(item2_counter == 1);
+        }
+        assert(item0_counter == 0);
+        assert(item1_counter == 0);
+        assert(item2_counter == 0);
+    }
+
+    {
+        bool exception_was_thrown = false;
+        //      ,     
+        for (int max_copy_counter = 5; max_copy_counter >= 0; --max_copy_counter) 
+        {
+            //   
+            SingleLinkedList<ThrowOnCopy> list;
+            list.PushFront(ThrowOnCopy{});
+            try 
+            {
+                int copy_counter = max_copy_counter;
                 list.PushFront(ThrowOnCopy(copy_counter));
                 //     ,      
                 assert(list.GetSize() == 2);
@@ -532,429 +1527,1257 @@ void Test1() {
             catch (const std::bad_alloc&)
             {
                 exception_was_thrown = true;
-                //        
-                assert(list.GetSize() == 1);
-                break;
+                //        
+                assert(list.GetSize() == 1);
+                break;
+            }
+        }
+        assert(exception_was_thrown);
+    }
+}
+
+void Test2() {
+    //    
+    {
+        SingleLinkedList<int> list;
+        //        begin()/end()
+        const auto& const_list = list;
+
+        //  begine  end      
+        assert(list.begin() == list.end());
+        assert(const_list.begin() == const_list.end());
+        assert(list.cbegin() == list.cend());
+        assert(list.cbegin() == const_list.begin());
+        assert(list.cend() == const_list.end());
+    }
+
+    //    
+    {
+        SingleLinkedList<int> list;
+        const auto& const_list = list;
+
+        list.PushFront(1);
+        assert(list.GetSize() == 1u);
+        assert(!list.IsEmpty());
+
+        assert(const_list.begin() != const_list.end());
+        assert(const_list.cbegin() != const_list.cend());
+        assert(list.begin() != list.end());
+
+        assert(const_list.begin() == const_list.cbegin());
+
+        assert(*list.cbegin() == 1);
+        *list.begin() = -1;
+        assert(*list.cbegin() == -1);
+
+        const auto old_begin = list.cbegin();
+        list.PushFront(2);
+        assert(list.GetSize() == 2);
+
+        const auto new_begin = list.cbegin();
+        assert(new_begin != old_begin);
+        //  
+        {
+            auto new_begin_copy(new_begin);
+            assert((++(new_begin_copy)) == old_begin);
+        }
+        //  
+        {
+            auto new_begin_copy(new_begin);
+            assert(((new_begin_copy)++) == new_begin);
+            assert(new_begin_copy == old_begin);
+        }
+        // ,         end()
+        {
+            auto old_begin_copy(old_begin);
+            assert((++old_begin_copy) == list.end());
+        }
+    }
+    //  
+    {
+        SingleLinkedList<int> list;
+        list.PushFront(1);
+        //  ConstItrator  Iterator
+        SingleLinkedList<int>::ConstIterator const_it(list.begin());
+        assert(const_it == list.cbegin());
+        assert(*const_it == *list.cbegin());
+
+        SingleLinkedList<int>::ConstIterator const_it1;
+        //  ConstIterator-  Iterator
+        const_it1 = list.begin();
+        assert(const_it1 == const_it);
+    }
+    //   ->
+    {
+        using namespace std;
+        SingleLinkedList<std::string> string_list;
+
+        string_list.PushFront("one"s);
+        assert(string_list.cbegin()->length() == 3u);
+        string_list.begin()->push_back('!');
+        assert(*string_list.begin() == "one!"s);
+    }
+}
+
+void Test3() {
+     //     
+    {
+        SingleLinkedList<int> list_1;
+        list_1.PushFront(1);
+        list_1.PushFront(2);
+
+        SingleLinkedList<int> list_2 ;
+        list_2.PushFront(1);
+        list_2.PushFront(2);
+        list_2.PushFront(3);
+
+        SingleLinkedList<int> list_1_copy;
+        list_1_copy.PushFront(1);
+        list_1_copy.PushFront(2);
+
+        SingleLinkedList<int> empty_list;
+        SingleLinkedList<int> another_empty_list;
+
+        //    
+        assert(list_1 == list_1);
+        assert(empty_list == empty_list);
+
+        //     ,    -  
+        assert(list_1 == list_1_copy);
+        assert(list_1 != list_2);
+        assert(list_2 != list_1);
+        assert(empty_list == another_empty_list);
+    }
+
+    //   
+    {
+        SingleLinkedList<int> first;
+        first.PushFront(1);
+        first.PushFront(2);
+
+        SingleLinkedList<int> second;
+        second.PushFront(10);
+        second.PushFront(11);
+        second.PushFront(15);
+
+        const auto old_first_begin = first.begin();
+        const auto old_second_begin = second.begin();
+        const auto old_first_size = first.GetSize();
+        const auto old_second_size = second.GetSize();
+
+        first.swap(second);
+
+        assert(second.begin() == old_first_begin);
+        assert(first.begin() == old_second_begin);
+        assert(second.GetSize() == old_first_size);
+        assert(first.GetSize() == old_second_size);
+
+         //    swap
+        {
+            using std::swap;
+
+            //        std::swap, 
+            //      
+            swap(first, second);
+
+            // ,    std::swap,   
+
+            //         ,
+            //   first.begin()      ,
+            //          
+            assert(first.begin() == old_first_begin);
+            assert(second.begin() == old_second_begin);
+            assert(first.GetSize() == old_first_size);
+            assert(second.GetSize() == old_second_size);
+        }
+    }
+
+    //     std::initializer_list
+    {
+        SingleLinkedList<int> list{ 1, 2, 3, 4, 5,6 ,7, 8, 9, 10, 11 };
+        assert(list.GetSize() == 11);
+        assert(!list.IsEmpty());        
+        assert(std::equal(list.begin(), list.end(), std::begin({ 1, 2, 3, 4, 5,6 ,7, 8, 9, 10, 11 })));
+    }
+
+    //   
+    {
+        using IntList = SingleLinkedList<int>;
+
+        assert((IntList{ 1, 2, 3 } < IntList{ 1, 2, 3, 1 }));
+        assert((IntList{ 1, 2, 3 } <= IntList{ 1, 2, 3, 4 }));
+        assert((IntList{ 1, 2, 4 } > IntList{ 1, 2, 3 }));
+        assert((IntList{ 1, 2, 3 } >= IntList{ 1, 2, 3 }));
+    }
+
+    //  
+    {
+        const SingleLinkedList<int> empty_list{};
+        //   
+        {
+            auto list_copy(empty_list);
+            assert(list_copy.IsEmpty());
+        }
+
+        SingleLinkedList<int> non_empty_list{ 1, 2, 3, 4 };
+        //   
+        {
+            auto list_copy(non_empty_list);
+
+            assert(non_empty_list.begin() != list_copy.begin());
+            assert(list_copy == non_empty_list);
+        }
+    }
+
+    //  
+    {
+        const SingleLinkedList<int> source_list{ 1, 2, 3, 4 };
+
+        SingleLinkedList<int> receiver{ 5, 4, 3, 2, 1 };
+        receiver = source_list;
+        assert(receiver.begin() != source_list.begin());
+        assert(receiver == source_list);
+    }
+
+    //   
+    {
+        SingleLinkedList<ThrowOnCopy> src_list;
+        src_list.PushFront(ThrowOnCopy{});
+        src_list.PushFront(ThrowOnCopy{});
+        auto thrower = src_list.begin();
+        src_list.PushFront(ThrowOnCopy{});
+
+        int copy_counter = 0;  //       
+        thrower->countdown_ptr = &copy_counter;
+
+        SingleLinkedList<ThrowOnCopy> dst_list;
+        dst_list.PushFront(ThrowOnCopy{});
+        int dst_counter = 10;
+        dst_list.begin()->countdown_ptr = &dst_counter;
+        dst_list.PushFront(ThrowOnCopy{});
+
+        try {
+            dst_list = src_list;
+            //    
+            assert(false);
+        }
+        catch (const std::bad_alloc&) {
+            // ,   -  
+            //   
+            assert(dst_list.GetSize() == 2);
+            auto it = dst_list.begin();
+            assert(it != dst_list.end());
+            assert(it->countdown_ptr == nullptr);
+            ++it;
+            assert(it != dst_list.end());
+            assert(it->countdown_ptr == &dst_counter);
+            assert(dst_counter == 10);
+        }
+        catch (...) {
+            //     
+            assert(false);
+        }
+    }
+}
+
+void Test4() {
+    struct DeletionSpy {
+        ~DeletionSpy() {
+            if (deletion_counter_ptr) {
+                ++(*deletion_counter_ptr);
+            }
+        }
+        int* deletion_counter_ptr = nullptr;
+    };
+
+    //  PopFront
+    {
+        SingleLinkedList<int> numbers{ 3, 14, 15, 92, 6 };       
+        numbers.PopFront();       
+        assert((numbers == SingleLinkedList<int>{14, 15, 92, 6}));
+
+        SingleLinkedList<DeletionSpy> list;
+        list.PushFront(DeletionSpy{});
+        int deletion_counter = 0;
+        list.begin()->deletion_counter_ptr = &deletion_counter;
+        assert(deletion_counter == 0);
+        list.PopFront();
+        assert(deletion_counter == 1);
+    }
+
+    //   ,  begin
+    {
+        SingleLinkedList<int> empty_list;
+        const auto& const_empty_list = empty_list;
+        assert(empty_list.before_begin() == empty_list.cbefore_begin());
+        assert(++empty_list.before_begin() == empty_list.begin());
+        assert(++empty_list.cbefore_begin() == const_empty_list.begin());
+
+        SingleLinkedList<int> numbers{ 1, 2, 3, 4 };
+        const auto& const_numbers = numbers;
+        assert(numbers.before_begin() == numbers.cbefore_begin());
+        assert(++numbers.before_begin() == numbers.begin());
+        assert(++numbers.cbefore_begin() == const_numbers.begin());
+    }
+
+     //    
+    {  //    
+        {
+            SingleLinkedList<int> lst;
+            const auto inserted_item_pos = lst.InsertAfter(lst.cbefore_begin(), 123);//
+            assert((lst == SingleLinkedList<int>{123}));
+            assert(inserted_item_pos == lst.begin());
+            assert(*inserted_item_pos == 123);
+        }
+
+        //    
+        {
+            SingleLinkedList<int> lst{ 1, 2, 3 };
+            auto inserted_item_pos = lst.InsertAfter(lst.before_begin(), 123);
+
+            assert(inserted_item_pos == lst.begin());
+            assert(inserted_item_pos != lst.end());
+            assert(*inserted_item_pos == 123);
+            assert((lst == SingleLinkedList<int>{123, 1, 2, 3}));
+
+            inserted_item_pos = lst.InsertAfter(lst.begin(), 555);
+            assert(++SingleLinkedList<int>::Iterator(lst.begin()) == inserted_item_pos);
+            assert(*inserted_item_pos == 555);
+            assert((lst == SingleLinkedList<int>{123, 555, 1, 2, 3}));
+        };
+    }
+
+    //      
+    {
+        bool exception_was_thrown = false;
+        for (int max_copy_counter = 10; max_copy_counter >= 0; --max_copy_counter) {
+            SingleLinkedList<ThrowOnCopy> list{ ThrowOnCopy{}, ThrowOnCopy{}, ThrowOnCopy{} };
+            try {
+                int copy_counter = max_copy_counter;
+                list.InsertAfter(list.cbegin(), ThrowOnCopy(copy_counter));
+                assert(list.GetSize() == 4u);
+            }
+            catch (const std::bad_alloc&) {
+                exception_was_thrown = true;
+                assert(list.GetSize() == 3u);
+                break;
+            }
+        }
+        assert(exception_was_thrown);
+    }
+
+    //     
+    {
+        {
+            SingleLinkedList<int> lst{ 1, 2, 3, 4 };
+            const auto& const_lst = lst;
+            const auto item_after_erased = lst.EraseAfter(const_lst.before_begin());
+            assert((lst == SingleLinkedList<int>{2, 3, 4}));
+            assert(item_after_erased == lst.begin());
+        }
+        {
+            SingleLinkedList<int> lst{ 1, 2, 3, 4 };
+            const auto item_after_erased = lst.EraseAfter(lst.cbegin());
+            assert((lst == SingleLinkedList<int>{1, 3, 4}));
+            assert(item_after_erased == (++lst.begin()));
+        }
+        {
+            SingleLinkedList<int> lst{ 1, 2, 3, 4 };
+            const auto item_after_erased = lst.EraseAfter(++(++lst.cbegin()));
+            assert((lst == SingleLinkedList<int>{1, 2, 3}));
+            assert(item_after_erased == lst.end());
+        }
+        {
+            SingleLinkedList<DeletionSpy> list{ DeletionSpy{}, DeletionSpy{}, DeletionSpy{} };
+            auto after_begin = ++list.begin();
+            int deletion_counter = 0;
+            after_begin->deletion_counter_ptr = &deletion_counter;
+            assert(deletion_counter == 0u);
+            list.EraseAfter(list.cbegin());
+            assert(deletion_counter == 1u);
+        }
+    }
+}
+
+void Test5() {
+    //   
+    {
+        SingleLinkedList<int> lst{ 1, 2, 5 };
+        SingleLinkedList<int> other{ 3, 4 };
+        const auto other_begin = other.begin();
+
+        lst.SpliceAfter(++lst.cbegin(), other);
+        assert((lst == SingleLinkedList<int>{1, 2, 3, 4, 5}));
+        assert(lst.GetSize() == 5u);
+        assert(other.IsEmpty());
+        assert(other.begin() == other.end());
+        //   ,  
+        assert(++(++lst.begin()) == other_begin);
+
+        SingleLinkedList<int> empty_list;
+        lst.SpliceAfter(lst.cbefore_begin(), empty_list);
+        assert(lst.GetSize() == 5u);
+
+        empty_list.SpliceAfter(empty_list.cbefore_begin(), lst);
+        assert((empty_list == SingleLinkedList<int>{1, 2, 3, 4, 5}));
+        assert(lst.IsEmpty());
+    }
+
+    //   (first, last)
+    {
+        SingleLinkedList<int> lst{ 1, 5 };
+        SingleLinkedList<int> other{ 0, 2, 3, 4, 6 };
+
+        auto last = other.cbegin();
+        for (int i = 0; i < 4; ++i)
+        {
+            ++last;
+        }
+        lst.SpliceAfter(lst.cbegin(), other, other.cbegin(), last);
+        assert((lst == SingleLinkedList<int>{1, 2, 3, 4, 5}));
+        assert((other == SingleLinkedList<int>{0, 6}));
+        assert(lst.GetSize() == 5u);
+        assert(other.GetSize() == 2u);
+
+        //     
+        lst.SpliceAfter(lst.cbefore_begin(), other, other.cbegin(), ++other.cbegin());
+        assert(lst.GetSize() == 5u && other.GetSize() == 2u);
+
+        //        
+        lst.SpliceAfter(lst.cbefore_begin(), lst, ++(++lst.cbegin()), lst.cend());
+        assert((lst == SingleLinkedList<int>{4, 5, 1, 2, 3}));
+        assert(lst.GetSize() == 5u);
+    }
+
+    //   
+    {
+        SingleLinkedList<int> lst{ 1, 3, 5, 7 };
+        SingleLinkedList<int> other{ 0, 2, 3, 8, 9 };
+        lst.Merge(other);
+        assert((lst == SingleLinkedList<int>{0, 1, 2, 3, 3, 5, 7, 8, 9}));
+        assert(lst.GetSize() == 9u);
+        assert(other.IsEmpty());
+
+        SingleLinkedList<int> descending{ 6, 4 };
+        SingleLinkedList<int> other_descending{ 9, 5, 1 };
+        descending.Merge(other_descending, std::greater<int>());
+        assert((descending == SingleLinkedList<int>{9, 6, 5, 4, 1}));
+
+        lst.Merge(lst);
+        assert(lst.GetSize() == 9u);
+    }
+
+    // 
+    {
+        SingleLinkedList<int> empty_list;
+        empty_list.Sort();
+        assert(empty_list.IsEmpty());
+
+        SingleLinkedList<int> lst{ 5, 3, 9, 1, 1, 8, 2, 7, 0, 6, 4 };
+        lst.Sort();
+        assert((lst == SingleLinkedList<int>{0, 1, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+        assert(lst.GetSize() == 11u);
+
+        lst.Sort(std::greater<int>());
+        assert((lst == SingleLinkedList<int>{9, 8, 7, 6, 5, 4, 3, 2, 1, 1, 0}));
+    }
+
+    //  :     
+    {
+        using Item = std::pair<int, int>;
+        SingleLinkedList<Item> lst{ {2, 0}, {1, 1}, {2, 2}, {0, 3}, {1, 4}, {2, 5}, {0, 6} };
+        lst.Sort([](const Item& lhs, const Item& rhs) { return lhs.first < rhs.first; });
+        assert((lst == SingleLinkedList<Item>{ {0, 3}, {0, 6}, {1, 1}, {1, 4}, {2, 0}, {2, 2}, {2, 5} }));
+    }
+
+    //        
+    {
+        bool exception_was_thrown = false;
+        for (int max_comparisons = 0; max_comparisons < 20; ++max_comparisons)
+        {
+            SingleLinkedList<int> lst{ 4, 3, 2, 1, 0, 7, 6, 5 };
+            int comparisons_left = max_comparisons;
+            try
+            {
+                lst.Sort([&comparisons_left](int lhs, int rhs) {
+                    if (comparisons_left-- == 0)
+                    {
+                        throw std::bad_alloc();
+                    }
+                    return lhs < rhs;
+                    });
+                assert((lst == SingleLinkedList<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+            }
+            catch (const std::bad_alloc&)
+            {
+                exception_was_thrown = true;
+                assert(lst.GetSize() == 8u);
+                int sum = 0;
+                size_t count = 0;
+                for (int value : lst)
+                {
+                    sum += value;
+                    ++count;
+                }
+                assert(count == 8u && sum == 28);
             }
         }
         assert(exception_was_thrown);
     }
 }
 
-void Test2() {
-    //    
+void Test6() {
+    //    
     {
-        SingleLinkedList<int> list;
-        //        begin()/end()
-        const auto& const_list = list;
-
-        //  begine  end      
-        assert(list.begin() == list.end());
-        assert(const_list.begin() == const_list.end());
-        assert(list.cbegin() == list.cend());
-        assert(list.cbegin() == const_list.begin());
-        assert(list.cend() == const_list.end());
+        const std::vector<int> values{ 1, 2, 3, 4, 5 };
+        SingleLinkedList<int> lst(values.begin(), values.end());
+        assert(lst.GetSize() == values.size());
+        assert(std::equal(lst.begin(), lst.end(), values.begin(), values.end()));
+
+        SingleLinkedList<int> empty_list(values.end(), values.end());
+        assert(empty_list.IsEmpty());
+        assert(empty_list.begin() == empty_list.end());
+
+        const std::string text = "abc";
+        SingleLinkedList<char> chars(text.begin(), text.end());
+        assert((chars == SingleLinkedList<char>{'a', 'b', 'c'}));
     }
 
-    //    
+    //     
     {
-        SingleLinkedList<int> list;
-        const auto& const_list = list;
+        const std::vector<int> values{ 2, 3, 4 };
+        SingleLinkedList<int> lst{ 1, 5 };
 
-        list.PushFront(1);
-        assert(list.GetSize() == 1u);
-        assert(!list.IsEmpty());
+        auto last_inserted = lst.InsertAfter(lst.cbegin(), values.begin(), values.end());
+        assert((lst == SingleLinkedList<int>{1, 2, 3, 4, 5}));
+        assert(lst.GetSize() == 5u);
+        assert(*last_inserted == 4);
+        assert(++last_inserted != lst.end() && *last_inserted == 5);
 
-        assert(const_list.begin() != const_list.end());
-        assert(const_list.cbegin() != const_list.cend());
-        assert(list.begin() != list.end());
+        const auto pos = lst.InsertAfter(lst.cbefore_begin(), values.end(), values.end());
+        assert(pos == lst.before_begin());
+        assert(lst.GetSize() == 5u);
 
-        assert(const_list.begin() == const_list.cbegin());
+        SingleLinkedList<int> empty_list;
+        empty_list.InsertAfter(empty_list.cbefore_begin(), values.begin(), values.end());
+        assert((empty_list == SingleLinkedList<int>{2, 3, 4}));
+    }
 
-        assert(*list.cbegin() == 1);
-        *list.begin() = -1;
-        assert(*list.cbegin() == -1);
+    //          
+    {
+        int copy_counter = 0;
+        std::vector<ThrowOnCopy> values(3);
+        values[2].countdown_ptr = &copy_counter;
 
-        const auto old_begin = list.cbegin();
-        list.PushFront(2);
-        assert(list.GetSize() == 2);
+        SingleLinkedList<ThrowOnCopy> lst{ ThrowOnCopy{}, ThrowOnCopy{} };
+        try
+        {
+            lst.InsertAfter(lst.cbegin(), values.begin(), values.end());
+            assert(false);
+        }
+        catch (const std::bad_alloc&)
+        {
+            assert(lst.GetSize() == 2u);
+            assert(std::distance(lst.begin(), lst.end()) == 2);
+        }
 
-        const auto new_begin = list.cbegin();
-        assert(new_begin != old_begin);
-        //  
+        try
         {
-            auto new_begin_copy(new_begin);
-            assert((++(new_begin_copy)) == old_begin);
+            SingleLinkedList<ThrowOnCopy> from_range(values.begin(), values.end());
+            assert(false);
         }
-        //  
+        catch (const std::bad_alloc&)
         {
-            auto new_begin_copy(new_begin);
-            assert(((new_begin_copy)++) == new_begin);
-            assert(new_begin_copy == old_begin);
         }
-        // ,         end()
+    }
+}
+
+void Test7() {
+    //    ForEach  ForEachBatch
+    {
+        SingleLinkedList<int> lst{ 1, 2, 3, 4, 5, 6, 7 };
+        const auto& const_lst = lst;
+
+        std::vector<int> visited;
+        const_lst.ForEach([&visited](int value) { visited.push_back(value); });
+        assert((visited == std::vector<int>{1, 2, 3, 4, 5, 6, 7}));
+
+        lst.ForEach([](int& value) { value *= 10; });
+        assert((lst == SingleLinkedList<int>{10, 20, 30, 40, 50, 60, 70}));
+
+        for (size_t batch_size : { 0u, 1u, 3u, 7u, 100u })
         {
-            auto old_begin_copy(old_begin);
-            assert((++old_begin_copy) == list.end());
+            visited.clear();
+            const_lst.ForEachBatch([&visited](int value) { visited.push_back(value); }, batch_size);
+            assert((visited == std::vector<int>{10, 20, 30, 40, 50, 60, 70}));
         }
+
+        lst.ForEachBatch([](int& value) { value /= 10; }, 4);
+        assert((lst == SingleLinkedList<int>{1, 2, 3, 4, 5, 6, 7}));
+
+        SingleLinkedList<int> empty_list;
+        empty_list.ForEach([](int) { assert(false); });
+        empty_list.ForEachBatch([](int) { assert(false); }, 8);
     }
-    //  
+
+    //       
     {
-        SingleLinkedList<int> list;
-        list.PushFront(1);
-        //  ConstItrator  Iterator
-        SingleLinkedList<int>::ConstIterator const_it(list.begin());
-        assert(const_it == list.cbegin());
-        assert(*const_it == *list.cbegin());
+        SingleLinkedList<std::string> lst{ "one", "two", "three", "four" };
+        lst.Compact();
+        assert((lst == SingleLinkedList<std::string>{"one", "two", "three", "four"}));
+        assert(lst.GetSize() == 4u);
+
+        lst.InsertAfter(lst.cbefore_begin(), "zero");
+        lst.Compact();
+        assert((lst == SingleLinkedList<std::string>{"zero", "one", "two", "three", "four"}));
+
+        SingleLinkedList<std::string> empty_list;
+        empty_list.Compact();
+        assert(empty_list.IsEmpty());
+    }
 
-        SingleLinkedList<int>::ConstIterator const_it1;
-        //  ConstIterator-  Iterator
-        const_it1 = list.begin();
-        assert(const_it1 == const_it);
+    //        ,        
+    {
+        SingleLinkedList<int> lst;
+        for (int i = 0; i < 6; ++i)
+        {
+            lst.PushFront(i);
+        }
+        lst.Compact();
+        const std::ptrdiff_t stride = reinterpret_cast<const char*>(&*++lst.begin()) - reinterpret_cast<const char*>(&*lst.begin());
+        for (auto it = lst.begin(), next = ++lst.begin(); next != lst.end(); ++it, ++next)
+        {
+            assert(reinterpret_cast<const char*>(&*next) - reinterpret_cast<const char*>(&*it) == stride);
+        }
+
+        size_t allocations_before = g_allocation_count;
+        lst.Compact();
+        assert(g_allocation_count == allocations_before);
+
+        //        :       
+        SingleLinkedList<int> other{ 10, 11 };
+        const auto moved_first = std::next(lst.cbegin());
+        const int* const moved_second = &*std::next(lst.cbegin(), 2);
+        allocations_before = g_allocation_count;
+        other.SpliceAfter(other.cbegin(), lst, lst.cbegin(), std::next(lst.cbegin(), 3));
+        assert(g_allocation_count == allocations_before);
+        assert((other == SingleLinkedList<int>{ 10, 4, 3, 11 }));
+        assert((lst == SingleLinkedList<int>{ 5, 2, 1, 0 }));
+        assert(std::next(other.cbegin()) == moved_first);
+        assert(&*std::next(other.cbegin(), 2) == moved_second);
+
+        lst.PopFront();
+        SingleLinkedList<int> moved(std::move(lst));
+        other.Sort();
+        moved.Sort();
+        moved.Merge(other);
+        assert((moved == SingleLinkedList<int>{ 0, 1, 2, 3, 4, 10, 11 }));
+        moved.Compact();
+        SingleLinkedList<int> tail{ 20 };
+        swap(tail, moved);
+        tail.SpliceAfter(tail.cbefore_begin(), moved);
+        assert((tail == SingleLinkedList<int>{ 20, 0, 1, 2, 3, 4, 10, 11 }));
     }
-    //   ->
+
+    //     ,     Compact
     {
-        using namespace std;
-        SingleLinkedList<std::string> string_list;
+        SingleLinkedList<std::string> receiver{ "head" };
+        {
+            SingleLinkedList<std::string> source{ "a", "b", "c", "d" };
+            source.Compact();
+            receiver.SpliceAfter(receiver.cbegin(), source, source.cbegin(), std::next(source.cbegin(), 3));
+            assert((source == SingleLinkedList<std::string>{ "a", "d" }));
+        }
+        assert((receiver == SingleLinkedList<std::string>{ "head", "b", "c" }));
+        receiver.PopFront();
+        receiver.Compact();
+        assert((receiver == SingleLinkedList<std::string>{ "b", "c" }));
+    }
 
-        string_list.PushFront("one"s);
-        assert(string_list.cbegin()->length() == 3u);
-        string_list.begin()->push_back('!');
-        assert(*string_list.begin() == "one!"s);
+    //     ,    
+    {
+        SingleLinkedList<ThrowOnCopy> lst{ ThrowOnCopy{}, ThrowOnCopy{}, ThrowOnCopy{} };
+        int copy_counter = 0;
+        auto thrower = ++lst.begin();
+        thrower->countdown_ptr = &copy_counter;
+        try
+        {
+            lst.Compact();
+            assert(false);
+        }
+        catch (const std::bad_alloc&)
+        {
+            assert(lst.GetSize() == 3u);
+            assert(++lst.begin() == thrower);
+            assert(thrower->countdown_ptr == &copy_counter);
+        }
     }
 }
 
-void Test3() {
-     //     
+void Test8() {
+    struct Item : IntrusiveListHook
     {
-        SingleLinkedList<int> list_1;
-        list_1.PushFront(1);
-        list_1.PushFront(2);
+        explicit Item(int v) : value(v) {}
+        int value = 0;
+    };
 
-        SingleLinkedList<int> list_2 ;
-        list_2.PushFront(1);
-        list_2.PushFront(2);
-        list_2.PushFront(3);
+    //    ,      
+    {
+        std::vector<Item> arena;
+        for (int i = 0; i < 5; ++i)
+        {
+            arena.emplace_back(i);
+        }
 
-        SingleLinkedList<int> list_1_copy;
-        list_1_copy.PushFront(1);
-        list_1_copy.PushFront(2);
+        IntrusiveSingleLinkedList<Item> list;
+        assert(list.IsEmpty());
+        assert(list.begin() == list.end());
+        assert(++list.before_begin() == list.begin());
 
-        SingleLinkedList<int> empty_list;
-        SingleLinkedList<int> another_empty_list;
+        list.PushFront(arena[2]);
+        list.PushFront(arena[0]);
+        assert(list.GetSize() == 2u);
+        assert(&*list.begin() == &arena[0]);
 
-        //    
-        assert(list_1 == list_1);
-        assert(empty_list == empty_list);
+        const auto inserted = list.InsertAfter(list.cbegin(), arena[1]);
+        assert(&*inserted == &arena[1]);
+        list.InsertAfter(inserted, arena[3]);
+        assert(list.GetSize() == 4u);
 
-        //     ,    -  
-        assert(list_1 == list_1_copy);
-        assert(list_1 != list_2);
-        assert(list_2 != list_1);
-        assert(empty_list == another_empty_list);
+        std::vector<int> values;
+        for (const Item& item : list)
+        {
+            values.push_back(item.value);
+        }
+        assert((values == std::vector<int>{0, 1, 3, 2}));
+
+        //         
+        const auto after_erased = list.EraseAfter(list.cbegin());
+        assert(&*after_erased == &arena[3]);
+        assert(list.GetSize() == 3u);
+        assert(arena[1].next_hook == nullptr);
+        assert(arena[1].value == 1);
+
+        list.InsertAfter(list.cbefore_begin(), arena[1]);
+        assert(&*list.begin() == &arena[1]);
+
+        list.PopFront();
+        assert(&*list.begin() == &arena[0]);
+        assert(list.GetSize() == 3u);
     }
 
-    //   
+    // ,    
     {
-        SingleLinkedList<int> first;
-        first.PushFront(1);
-        first.PushFront(2);
+        std::vector<Item> arena;
+        for (int i = 0; i < 3; ++i)
+        {
+            arena.emplace_back(i);
+        }
 
-        SingleLinkedList<int> second;
-        second.PushFront(10);
-        second.PushFront(11);
-        second.PushFront(15);
+        IntrusiveSingleLinkedList<Item> first;
+        first.PushFront(arena[0]);
+        first.PushFront(arena[1]);
 
-        const auto old_first_begin = first.begin();
-        const auto old_second_begin = second.begin();
-        const auto old_first_size = first.GetSize();
-        const auto old_second_size = second.GetSize();
+        IntrusiveSingleLinkedList<Item> second;
+        second.PushFront(arena[2]);
 
-        first.swap(second);
+        swap(first, second);
+        assert(first.GetSize() == 1u && &*first.begin() == &arena[2]);
+        assert(second.GetSize() == 2u && &*second.begin() == &arena[1]);
 
-        assert(second.begin() == old_first_begin);
-        assert(first.begin() == old_second_begin);
-        assert(second.GetSize() == old_first_size);
-        assert(first.GetSize() == old_second_size);
+        IntrusiveSingleLinkedList<Item> moved(std::move(second));
+        assert(moved.GetSize() == 2u && second.IsEmpty());
 
-         //    swap
-        {
-            using std::swap;
+        moved.Clear();
+        assert(moved.IsEmpty());
+        assert(arena[0].next_hook == nullptr && arena[1].next_hook == nullptr);
 
-            //        std::swap, 
-            //      
-            swap(first, second);
+        // ,   ,    
+        first.PushFront(arena[0]);
+        assert(first.GetSize() == 2u);
 
-            // ,    std::swap,   
+        //     ,    
+        Item copy = arena[0];
+        assert(copy.next_hook == nullptr && copy.value == 0);
+        moved.PushFront(copy);
 
-            //         ,
-            //   first.begin()      ,
-            //          
-            assert(first.begin() == old_first_begin);
-            assert(second.begin() == old_second_begin);
-            assert(first.GetSize() == old_first_size);
-            assert(second.GetSize() == old_second_size);
+        arena[0] = Item(7);
+        assert(arena[0].next_hook == &arena[2] && arena[0].value == 7);
+        copy = arena[0];
+        assert(copy.next_hook == nullptr && copy.value == 7);
+        assert(&*moved.begin() == &copy && moved.GetSize() == 1u);
+        moved.Clear();
+    }
+}
+
+void Test9() {
+    using SmallList = SingleLinkedList<int, 8>;
+
+    //       
+    {
+        const size_t allocations_before = g_allocation_count;
+        {
+            SmallList lst;
+            for (int i = 0; i < 8; ++i)
+            {
+                lst.PushFront(i);
+            }
+            lst.PopFront();
+            lst.EraseAfter(lst.cbegin());
+            lst.InsertAfter(lst.cbefore_begin(), 100);
+            lst.InsertAfter(lst.cbegin(), 200);
+            assert(lst.GetSize() == 8u);
+            assert((lst == SmallList{ 100, 200, 6, 4, 3, 2, 1, 0 }));
+
+            SmallList copy(lst);
+            SmallList moved(std::move(copy));
+            assert(moved == lst);
+            assert(copy.IsEmpty());
         }
+        assert(g_allocation_count == allocations_before);
     }
 
-    //     std::initializer_list
+    //        
     {
-        SingleLinkedList<int> list{ 1, 2, 3, 4, 5,6 ,7, 8, 9, 10, 11 };
-        assert(list.GetSize() == 11);
-        assert(!list.IsEmpty());        
-        assert(std::equal(list.begin(), list.end(), std::begin({ 1, 2, 3, 4, 5,6 ,7, 8, 9, 10, 11 })));
+        SmallList lst;
+        for (int i = 0; i < 8; ++i)
+        {
+            lst.PushFront(i);
+        }
+        const size_t allocations_before = g_allocation_count;
+        lst.PushFront(8);
+        lst.PushFront(9);
+        assert(g_allocation_count == allocations_before + 2);
+        assert(lst.GetSize() == 10u);
+
+        //     
+        lst.EraseAfter(++lst.cbegin());
+        lst.InsertAfter(lst.cbegin(), 42);
+        assert(g_allocation_count == allocations_before + 2);
+        assert((lst == SmallList{ 9, 42, 8, 6, 5, 4, 3, 2, 1, 0 }));
+
+        lst.Compact();
+        assert((lst == SmallList{ 9, 42, 8, 6, 5, 4, 3, 2, 1, 0 }));
+    }
+
+    //         
+    {
+        SmallList small{ 1, 2, 3 };
+        SmallList large{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+        swap(small, large);
+        assert((small == SmallList{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }));
+        assert((large == SmallList{ 1, 2, 3 }));
+        assert(small.GetSize() == 11u && large.GetSize() == 3u);
+
+        small = std::move(large);
+        assert((small == SmallList{ 1, 2, 3 }));
+        assert(large.IsEmpty());
+
+        large = small;
+        small.swap(small);
+        assert(small == large);
+    }
+
+    //         
+    {
+        SmallList lst{ 1, 4 };
+        SmallList other{ 2, 3 };
+        lst.SpliceAfter(lst.cbegin(), other);
+        assert((lst == SmallList{ 1, 2, 3, 4 }));
+        assert(other.IsEmpty());
+
+        SmallList range_source{ 0, 5, 6, 9 };
+        lst.SpliceAfter(++(++(++lst.cbegin())), range_source, range_source.cbegin(), ++(++(++range_source.cbegin())));
+        assert((lst == SmallList{ 1, 2, 3, 4, 5, 6 }));
+        assert((range_source == SmallList{ 0, 9 }));
+
+        lst.Merge(range_source);
+        assert((lst == SmallList{ 0, 1, 2, 3, 4, 5, 6, 9 }));
+        lst.Sort(std::greater<int>());
+        assert((lst == SmallList{ 9, 6, 5, 4, 3, 2, 1, 0 }));
     }
+}
 
-    //   
-    {
-        using IntList = SingleLinkedList<int>;
+void Test10() {
+    using IntList = SingleLinkedList<int>;
 
-        assert((IntList{ 1, 2, 3 } < IntList{ 1, 2, 3, 1 }));
-        assert((IntList{ 1, 2, 3 } <= IntList{ 1, 2, 3, 4 }));
-        assert((IntList{ 1, 2, 4 } > IntList{ 1, 2, 3 }));
-        assert((IntList{ 1, 2, 3 } >= IntList{ 1, 2, 3 }));
+    //  ,   operator<
+    {
+        assert((IntList{ 1, 2, 3 } <= IntList{ 1, 2, 3 }));
+        assert(!(IntList{ 1, 2, 4 } <= IntList{ 1, 2, 3 }));
+        assert(!(IntList{ 1, 2, 3 } > IntList{ 1, 2, 3 }));
+        assert(!(IntList{ 1, 2 } > IntList{ 1, 2, 3 }));
+        assert(!(IntList{ 1, 2, 3 } >= IntList{ 1, 2, 4 }));
+        assert((IntList{} < IntList{ 0 }));
+        assert((IntList{} <= IntList{}));
     }
 
-    //  
+    //        
     {
-        const SingleLinkedList<int> empty_list{};
-        //   
+        struct CountingInt
         {
-            auto list_copy(empty_list);
-            assert(list_copy.IsEmpty());
-        }
+            int value = 0;
+            int* comparisons = nullptr;
 
-        SingleLinkedList<int> non_empty_list{ 1, 2, 3, 4 };
-        //   
-        {
-            auto list_copy(non_empty_list);
+            bool operator==(const CountingInt& rhs) const
+            {
+                ++(*comparisons);
+                return value == rhs.value;
+            }
+        };
 
-            assert(non_empty_list.begin() != list_copy.begin());
-            assert(list_copy == non_empty_list);
-        }
+        int comparisons = 0;
+        const SingleLinkedList<CountingInt> short_list{ {1, &comparisons}, {2, &comparisons} };
+        const SingleLinkedList<CountingInt> long_list{ {1, &comparisons}, {2, &comparisons}, {3, &comparisons} };
+        assert(short_list != long_list);
+        assert(comparisons == 0);
+
+        const SingleLinkedList<CountingInt> short_list_copy(short_list);
+        assert(short_list == short_list_copy);
+        assert(comparisons == 2);
     }
 
-    //  
+    //  
     {
-        const SingleLinkedList<int> source_list{ 1, 2, 3, 4 };
+        const std::hash<IntList> hasher;
+        assert(hasher(IntList{ 1, 2, 3 }) == hasher(IntList{ 1, 2, 3 }));
+        assert(hasher(IntList{ 1, 2, 3 }) != hasher(IntList{ 3, 2, 1 }));
+        assert(hasher(IntList{}) != hasher(IntList{ 0 }));
+
+        std::unordered_set<IntList> unique_lists;
+        unique_lists.insert(IntList{ 1, 2, 3 });
+        unique_lists.insert(IntList{ 1, 2, 3 });
+        unique_lists.insert(IntList{ 1, 2 });
+        assert(unique_lists.size() == 2u);
+        assert(unique_lists.count(IntList{ 1, 2 }) == 1u);
+
+        using SmallList = SingleLinkedList<std::string, 4>;
+        assert(std::hash<SmallList>()(SmallList{ "a", "b" }) == std::hash<SmallList>()(SmallList{ "a", "b" }));
+    }
 
-        SingleLinkedList<int> receiver{ 5, 4, 3, 2, 1 };
-        receiver = source_list;
-        assert(receiver.begin() != source_list.begin());
-        assert(receiver == source_list);
+#if defined(__cpp_lib_three_way_comparison)
+    //  
+    {
+        assert((IntList{ 1, 2, 3 } <=> IntList{ 1, 2, 4 }) < 0);
+        assert((IntList{ 1, 2, 3 } <=> IntList{ 1, 2, 3 }) == 0);
+        assert((IntList{ 1, 2, 3, 0 } <=> IntList{ 1, 2, 3 }) > 0);
     }
+#endif
+}
 
-    //  ,     N-
-    struct ThrowOnCopy {
-        ThrowOnCopy() = default;
-        explicit ThrowOnCopy(int& copy_counter) noexcept
-            : countdown_ptr(&copy_counter) {
-        }
-        ThrowOnCopy(const ThrowOnCopy& other)
-            : countdown_ptr(other.countdown_ptr)  //
-        {
-            if (countdown_ptr) {
-                if (*countdown_ptr == 0) {
-                    throw std::bad_alloc();
-                }
-                else {
-                    --(*countdown_ptr);
-                }
-            }
-        }
-        //      
-        ThrowOnCopy& operator=(const ThrowOnCopy& rhs) = delete;
-        //    .    nullptr,     .
-        //   ,    
-        int* countdown_ptr = nullptr;
-    };
+#ifdef LIST_BENCHMARK
+//    .    -DLIST_BENCHMARK,
+//      -DLIST_BENCHMARK_MAX_SIZE=N.
+//        std::forward_list  std::vector
 
-    //   
-    {
-        SingleLinkedList<ThrowOnCopy> src_list;
-        src_list.PushFront(ThrowOnCopy{});
-        src_list.PushFront(ThrowOnCopy{});
-        auto thrower = src_list.begin();
-        src_list.PushFront(ThrowOnCopy{});
+#ifndef LIST_BENCHMARK_MAX_SIZE
+#define LIST_BENCHMARK_MAX_SIZE 10000000
+#endif
 
-        int copy_counter = 0;  //       
-        thrower->countdown_ptr = &copy_counter;
+//            
+const std::chrono::milliseconds MIN_BENCHMARK_TIME{ 100 };
+const std::chrono::seconds MAX_BENCHMARK_WALL_TIME{ 3 };
 
-        SingleLinkedList<ThrowOnCopy> dst_list;
-        dst_list.PushFront(ThrowOnCopy{});
-        int dst_counter = 10;
-        dst_list.begin()->countdown_ptr = &dst_counter;
-        dst_list.PushFront(ThrowOnCopy{});
+//      ,       
+const std::chrono::milliseconds MIN_BATCH_TIME{ 1 };
 
-        try {
-            dst_list = src_list;
-            //    
-            assert(false);
+//     ,       O(n)
+const size_t LINEAR_BENCHMARK_WORK = 100000;
+
+//    ,      
+volatile int g_benchmark_sink = 0;
+
+struct BenchmarkResult
+{
+    double ns_per_op = 0.0;
+    double allocs_per_op = 0.0;
+    double bytes_per_op = 0.0;
+};
+
+//  ,      MIN_BENCHMARK_TIME.
+// setup()     , run(state)  ops .
+//    MIN_BATCH_TIME,       :
+//     .     
+template <typename Setup, typename Run>
+BenchmarkResult RunBenchmark(Setup setup, Run run, size_t ops)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto wall_start = Clock::now();
+    Clock::duration measured{};
+    size_t allocations = 0;
+    size_t bytes = 0;
+    size_t total_ops = 0;
+    size_t batch_size = 1;
+
+    do
+    {
+        std::vector<std::invoke_result_t<Setup&>> states;
+        states.reserve(batch_size);
+        for (size_t i = 0; i < batch_size; ++i)
+        {
+            states.push_back(setup());
         }
-        catch (const std::bad_alloc&) {
-            // ,   -  
-            //   
-            assert(dst_list.GetSize() == 2);
-            auto it = dst_list.begin();
-            assert(it != dst_list.end());
-            assert(it->countdown_ptr == nullptr);
-            ++it;
-            assert(it != dst_list.end());
-            assert(it->countdown_ptr == &dst_counter);
-            assert(dst_counter == 10);
+        const size_t allocations_before = g_allocation_count;
+        const size_t bytes_before = g_allocated_bytes;
+        const auto start = Clock::now();
+        for (auto& state : states)
+        {
+            run(state);
         }
-        catch (...) {
-            //     
-            assert(false);
+        const auto elapsed = Clock::now() - start;
+        measured += elapsed;
+        allocations += g_allocation_count - allocations_before;
+        bytes += g_allocated_bytes - bytes_before;
+        total_ops += ops * batch_size;
+        if (elapsed < MIN_BATCH_TIME)
+        {
+            batch_size *= 2;
         }
-    }
+    } while (measured < MIN_BENCHMARK_TIME && Clock::now() - wall_start < MAX_BENCHMARK_WALL_TIME);
+
+    BenchmarkResult result;
+    result.ns_per_op = std::chrono::duration<double, std::nano>(measured).count() / total_ops;
+    result.allocs_per_op = static_cast<double>(allocations) / total_ops;
+    result.bytes_per_op = static_cast<double>(bytes) / total_ops;
+    return result;
 }
 
-void Test4() {
-    struct DeletionSpy {
-        ~DeletionSpy() {
-            if (deletion_counter_ptr) {
-                ++(*deletion_counter_ptr);
-            }
-        }
-        int* deletion_counter_ptr = nullptr;
-    };
+void PrintBenchmarkHeader()
+{
+    std::cout << std::left << std::setw(44) << "Benchmark"
+        << std::right << std::setw(16) << "ns/op"
+        << std::setw(12) << "allocs/op"
+        << std::setw(12) << "bytes/op" << std::endl;
+}
 
-    //  PopFront
-    {
-        SingleLinkedList<int> numbers{ 3, 14, 15, 92, 6 };       
-        numbers.PopFront();       
-        assert((numbers == SingleLinkedList<int>{14, 15, 92, 6}));
+void PrintBenchmarkResult(const std::string& name, const BenchmarkResult& result)
+{
+    std::cout << std::left << std::setw(44) << name
+        << std::right << std::fixed << std::setprecision(2)
+        << std::setw(16) << result.ns_per_op
+        << std::setw(12) << result.allocs_per_op
+        << std::setw(12) << result.bytes_per_op << std::endl;
+}
 
-        SingleLinkedList<DeletionSpy> list;
-        list.PushFront(DeletionSpy{});
-        int deletion_counter = 0;
-        list.begin()->deletion_counter_ptr = &deletion_counter;
-        assert(deletion_counter == 0);
-        list.PopFront();
-        assert(deletion_counter == 1);
-    }
+//    ,      O(size)
+size_t BoundedOps(size_t size)
+{
+    return std::clamp<size_t>(LINEAR_BENCHMARK_WORK / size, 1, size);
+}
 
-    //   ,  begin
+template <typename Container>
+Container MakeBenchmarkContainer(size_t size)
+{
+    std::vector<int> values(size);
+    for (size_t i = 0; i < size; ++i)
     {
-        SingleLinkedList<int> empty_list;
-        const auto& const_empty_list = empty_list;
-        assert(empty_list.before_begin() == empty_list.cbefore_begin());
-        assert(++empty_list.before_begin() == empty_list.begin());
-        assert(++empty_list.cbefore_begin() == const_empty_list.begin());
+        values[i] = static_cast<int>(i);
+    }
+    return Container(values.begin(), values.end());
+}
 
-        SingleLinkedList<int> numbers{ 1, 2, 3, 4 };
-        const auto& const_numbers = numbers;
-        assert(numbers.before_begin() == numbers.cbefore_begin());
-        assert(++numbers.before_begin() == numbers.begin());
-        assert(++numbers.cbefore_begin() == const_numbers.begin());
+template <typename Container>
+constexpr bool IS_VECTOR = std::is_same_v<Container, std::vector<int>>;
+
+template <typename Container>
+void PushFrontOnce(Container& container, int value)
+{
+    if constexpr (IS_VECTOR<Container>)
+    {
+        container.insert(container.begin(), value);
+    }
+    else if constexpr (std::is_same_v<Container, std::forward_list<int>>)
+    {
+        container.push_front(value);
+    }
+    else
+    {
+        container.PushFront(value);
     }
+}
 
-     //    
-    {  //    
+template <typename Container>
+void PushBackOnce(Container& container, int value)
+{
+    if constexpr (IS_VECTOR<Container>)
+    {
+        container.push_back(value);
+    }
+    else if constexpr (std::is_same_v<Container, std::forward_list<int>>)
+    {
+        //  std::forward_list  push_back:   SingleLinkedList,   
+        auto last = container.before_begin();
+        for (auto it = container.begin(); it != container.end(); ++it)
         {
-            SingleLinkedList<int> lst;
-            const auto inserted_item_pos = lst.InsertAfter(lst.cbefore_begin(), 123);//
-            assert((lst == SingleLinkedList<int>{123}));
-            assert(inserted_item_pos == lst.begin());
-            assert(*inserted_item_pos == 123);
+            last = it;
         }
+        container.insert_after(last, value);
+    }
+    else
+    {
+        container.PushBack(value);
+    }
+}
 
-        //    
-        {
-            SingleLinkedList<int> lst{ 1, 2, 3 };
-            auto inserted_item_pos = lst.InsertAfter(lst.before_begin(), 123);
+template <typename Container>
+void InsertAfterFirst(Container& container, int value)
+{
+    if constexpr (IS_VECTOR<Container>)
+    {
+        container.insert(container.begin() + 1, value);
+    }
+    else if constexpr (std::is_same_v<Container, std::forward_list<int>>)
+    {
+        container.insert_after(container.cbegin(), value);
+    }
+    else
+    {
+        container.InsertAfter(container.cbegin(), value);
+    }
+}
 
-            assert(inserted_item_pos == lst.begin());
-            assert(inserted_item_pos != lst.end());
-            assert(*inserted_item_pos == 123);
-            assert((lst == SingleLinkedList<int>{123, 1, 2, 3}));
+template <typename Container>
+void EraseAfterFirst(Container& container)
+{
+    if constexpr (IS_VECTOR<Container>)
+    {
+        container.erase(container.begin() + 1);
+    }
+    else if constexpr (std::is_same_v<Container, std::forward_list<int>>)
+    {
+        container.erase_after(container.cbegin());
+    }
+    else
+    {
+        container.EraseAfter(container.cbegin());
+    }
+}
 
-            inserted_item_pos = lst.InsertAfter(lst.begin(), 555);
-            assert(++SingleLinkedList<int>::Iterator(lst.begin()) == inserted_item_pos);
-            assert(*inserted_item_pos == 555);
-            assert((lst == SingleLinkedList<int>{123, 555, 1, 2, 3}));
-        };
+template <typename Container>
+void ClearContainer(Container& container)
+{
+    if constexpr (IS_VECTOR<Container> || std::is_same_v<Container, std::forward_list<int>>)
+    {
+        container.clear();
+    }
+    else
+    {
+        container.Clear();
     }
+}
 
-    //  ,     N-
-    struct ThrowOnCopy {
-        ThrowOnCopy() = default;
-        explicit ThrowOnCopy(int& copy_counter) noexcept
-            : countdown_ptr(&copy_counter) {
-        }
-        ThrowOnCopy(const ThrowOnCopy& other)
-            : countdown_ptr(other.countdown_ptr)  //
-        {
-            if (countdown_ptr) {
-                if (*countdown_ptr == 0) {
-                    throw std::bad_alloc();
-                }
-                else {
-                    --(*countdown_ptr);
-                }
-            }
-        }
-        //      
-        ThrowOnCopy& operator=(const ThrowOnCopy& rhs) = delete;
-        //    .    nullptr,     .
-        //   ,    
-        int* countdown_ptr = nullptr;
+template <typename Container>
+void BenchmarkContainer(const std::string& container_name, size_t size)
+{
+    const std::string suffix = "/" + container_name + "/" + std::to_string(size);
+    const auto make_filled = [size] {
+        return MakeBenchmarkContainer<Container>(size);
     };
 
-    //      
     {
-        bool exception_was_thrown = false;
-        for (int max_copy_counter = 10; max_copy_counter >= 0; --max_copy_counter) {
-            SingleLinkedList<ThrowOnCopy> list{ ThrowOnCopy{}, ThrowOnCopy{}, ThrowOnCopy{} };
-            try {
-                int copy_counter = max_copy_counter;
-                list.InsertAfter(list.cbegin(), ThrowOnCopy(copy_counter));
-                assert(list.GetSize() == 4u);
+        const size_t ops = IS_VECTOR<Container> ? BoundedOps(size) : size;
+        PrintBenchmarkResult("PushFront" + suffix, RunBenchmark(make_filled, [ops](Container& container) {
+            for (size_t i = 0; i < ops; ++i)
+            {
+                PushFrontOnce(container, static_cast<int>(i));
             }
-            catch (const std::bad_alloc&) {
-                exception_was_thrown = true;
-                assert(list.GetSize() == 3u);
-                break;
+            }, ops));
+    }
+    {
+        const size_t ops = IS_VECTOR<Container> ? size : BoundedOps(size);
+        PrintBenchmarkResult("PushBack" + suffix, RunBenchmark(make_filled, [ops](Container& container) {
+            for (size_t i = 0; i < ops; ++i)
+            {
+                PushBackOnce(container, static_cast<int>(i));
             }
-        }
-        assert(exception_was_thrown);
+            }, ops));
     }
-
-    //     
     {
+        const size_t ops = IS_VECTOR<Container> ? BoundedOps(size) : size;
+        PrintBenchmarkResult("InsertAfter" + suffix, RunBenchmark(make_filled, [ops](Container& container) {
+            for (size_t i = 0; i < ops; ++i)
+            {
+                InsertAfterFirst(container, static_cast<int>(i));
+            }
+            }, ops));
+    }
+    if (size > 1)
+    {
+        const size_t ops = IS_VECTOR<Container> ? std::min(BoundedOps(size), size - 1) : size - 1;
+        PrintBenchmarkResult("EraseAfter" + suffix, RunBenchmark(make_filled, [ops](Container& container) {
+            for (size_t i = 0; i < ops; ++i)
+            {
+                EraseAfterFirst(container);
+            }
+            }, ops));
+    }
+
+    //        ,     
+    const Container source = make_filled();
+    PrintBenchmarkResult("CopyConstruct" + suffix, RunBenchmark([] { return 0; }, [&source](int) {
+        Container copy(source);
+        g_benchmark_sink = g_benchmark_sink + *copy.begin();
+        }, size));
+    PrintBenchmarkResult("Assign" + suffix, RunBenchmark([size] {
+        return MakeBenchmarkContainer<Container>(size);
+        }, [&source](Container& container) {
+            container = source;
+        }, size));
+    PrintBenchmarkResult("Iterate" + suffix, RunBenchmark([] { return 0; }, [&source](int) {
+        int sum = 0;
+        for (int value : source)
         {
-            SingleLinkedList<int> lst{ 1, 2, 3, 4 };
-            const auto& const_lst = lst;
-            const auto item_after_erased = lst.EraseAfter(const_lst.before_begin());
-            assert((lst == SingleLinkedList<int>{2, 3, 4}));
-            assert(item_after_erased == lst.begin());
-        }
-        {
-            SingleLinkedList<int> lst{ 1, 2, 3, 4 };
-            const auto item_after_erased = lst.EraseAfter(lst.cbegin());
-            assert((lst == SingleLinkedList<int>{1, 3, 4}));
-            assert(item_after_erased == (++lst.begin()));
-        }
-        {
-            SingleLinkedList<int> lst{ 1, 2, 3, 4 };
-            const auto item_after_erased = lst.EraseAfter(++(++lst.cbegin()));
-            assert((lst == SingleLinkedList<int>{1, 2, 3}));
-            assert(item_after_erased == lst.end());
+            sum += value;
         }
+        g_benchmark_sink = sum;
+        }, size));
+    PrintBenchmarkResult("Clear" + suffix, RunBenchmark(make_filled, [](Container& container) {
+        ClearContainer(container);
+        }, size));
+}
+
+//             
+template <size_t InlineCapacity>
+double MeasureAllocationsPerList(int list_size, int repetitions)
+{
+    const size_t allocations_before = g_allocation_count;
+    for (int i = 0; i < repetitions; ++i)
+    {
+        SingleLinkedList<int, InlineCapacity> lst;
+        for (int value = 0; value < list_size; ++value)
         {
-            SingleLinkedList<DeletionSpy> list{ DeletionSpy{}, DeletionSpy{}, DeletionSpy{} };
-            auto after_begin = ++list.begin();
-            int deletion_counter = 0;
-            after_begin->deletion_counter_ptr = &deletion_counter;
-            assert(deletion_counter == 0u);
-            list.EraseAfter(list.cbegin());
-            assert(deletion_counter == 1u);
+            lst.PushFront(value);
         }
     }
+    return static_cast<double>(g_allocation_count - allocations_before) / repetitions;
 }
 
+void BenchmarkShortListAllocations()
+{
+    const int repetitions = 1000;
+    std::cout << "size\tallocs/list (heap)\tallocs/list (inline 8)" << std::endl;
+    for (int list_size = 1; list_size <= 10; ++list_size)
+    {
+        std::cout << list_size << '\t'
+            << MeasureAllocationsPerList<0>(list_size, repetitions) << '\t'
+            << MeasureAllocationsPerList<8>(list_size, repetitions) << std::endl;
+    }
+}
 
+void RunListBenchmarks()
+{
+    PrintBenchmarkHeader();
+    for (size_t size = 10; size <= LIST_BENCHMARK_MAX_SIZE; size *= 10)
+    {
+        BenchmarkContainer<SingleLinkedList<int>>("SingleLinkedList", size);
+        BenchmarkContainer<std::forward_list<int>>("forward_list", size);
+        BenchmarkContainer<std::vector<int>>("vector", size);
+    }
+    std::cout << std::endl;
+    BenchmarkShortListAllocations();
+}
+#endif
 
 int main() {
 
@@ -962,4 +2785,14 @@ int main() {
     Test2();
     Test3();
     Test4();
+    Test5();
+    Test6();
+    Test7();
+    Test8();
+    Test9();
+    Test10();
+
+#ifdef LIST_BENCHMARK
+    RunListBenchmarks();
+#endif
 }
\ No newline at end of file